@@ -0,0 +1,119 @@
+/**************************************************************************
+ * Copyright (c) 2015 Afa.L Cheng <afa@afa.moe>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ***************************************************************************/
+
+// Times the scanner with and without the comment prescan fast path.
+//
+// Usage: LexerBenchmark [sourcefile [rounds]]
+//
+// Without a source file, a unit of functions with short and long comments
+// is generated.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "lex_helper.h"
+#include "tokenbuffer.h"
+
+static std::string generated_source()
+{
+    std::string text;
+    for (int i = 0; i < 2000; ++i) {
+        std::string n = std::to_string(i);
+        text += "-_- @f" + n + " adds its arguments >_<\n";
+        text += "def @f" + n + "(a`1, a`2) {\n";
+        text += "    -_-\n";
+        for (int line = 0; line < 8; ++line)
+            text += "       A longer comment that runs over several rows, like the header of a function.\n";
+        text += "    >_<\n";
+        text += "    var a`3 = a`1 + a`2 * " + n + "\n";
+        text += "    print(\"sum\", a`3) -_- trailing >_<\n";
+        text += "    return a`3\n";
+        text += "}\n\n";
+    }
+    return text;
+}
+
+// Lexes text once and returns the number of tokens
+static size_t lex(const std::string &text, bool prescan)
+{
+    LexerContext lexer;
+    lexer.init(text.data(), text.size(), "benchmark.anna");
+    lexer.setPrescan(prescan);
+
+    TokenBuffer tokens;
+    tokens.setSource(lexer.source());
+
+    size_t count = 0;
+    while (lexer.scan(tokens) > 0) {
+        ++count;
+        tokens.discard(tokens.end());
+    }
+    return count;
+}
+
+static double time_lex(const std::string &text, bool prescan, int rounds, size_t &count)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i)
+        count = lex(text, prescan);
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / rounds;
+}
+
+int main(int argc, char **argv)
+{
+    std::string text;
+    if (argc > 1) {
+        std::ifstream in(argv[1], std::ios::binary);
+        if (!in) {
+            std::fprintf(stderr, "Cannot open file %s for read.\n", argv[1]);
+            return 2;
+        }
+        text.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    } else {
+        text = generated_source();
+    }
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 20;
+
+    size_t withCount = 0;
+    size_t withoutCount = 0;
+    // Warm up, then alternate so both see the same machine state
+    time_lex(text, true, 1, withCount);
+    double with = time_lex(text, true, rounds, withCount);
+    double without = time_lex(text, false, rounds, withoutCount);
+
+    std::printf("%zu bytes, %zu tokens, %d rounds\n", text.size(), withCount, rounds);
+    std::printf("prescan on:  %8.3f ms per pass\n", with);
+    std::printf("prescan off: %8.3f ms per pass\n", without);
+
+    if (withCount != withoutCount) {
+        std::fprintf(stderr, "Token counts differ: %zu with prescan, %zu without\n", withCount, withoutCount);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+/**************************************************************************
+ * Copyright (c) 2015 Afa.L Cheng <afa@afa.moe>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ***************************************************************************/
+
+// Times parsing of deeply nested parentheses with and without the packrat
+// memo.
+//
+// Usage: NestingBenchmark [rounds]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "parser.h"
+
+static std::string nested_source(int depth)
+{
+    return "var a`1 = " + std::string(depth, '(') + "1" + std::string(depth, ')') + "\n";
+}
+
+// Milliseconds per parse of text, or a negative number if parsing failed
+static double time_parse(const std::string &text, bool memoize, int rounds)
+{
+    bool failed = false;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < rounds; ++i) {
+        AnnaParser parser(text.data(), text.size(), "nesting.anna", "nesting.anna");
+        parser.setMemoization(memoize);
+        gcnCompilationUnit unit = parser.parse();
+        failed = failed || !unit || parser.hasErrors();
+    }
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return failed ? -1 : elapsed.count() / rounds;
+}
+
+int main(int argc, char **argv)
+{
+    int rounds = argc > 1 ? std::atoi(argv[1]) : 20;
+
+    // Depths stay under the default nesting limit of 1000
+    for (int depth : {16, 100, 400, 800}) {
+        std::string text = nested_source(depth);
+        for (bool memoize : {false, true}) {
+            double ms = time_parse(text, memoize, rounds);
+            if (ms < 0)
+                std::printf("%4d levels, memo %-3s:   failed\n", depth, memoize ? "on" : "off");
+            else
+                std::printf("%4d levels, memo %-3s: %8.3f ms\n", depth, memoize ? "on" : "off", ms);
+        }
+    }
+
+    return 0;
+}
@@ -1,7 +1,7 @@
 TARGET = Parser
 TEMPLATE = lib
 CONFIG -= qt
-CONFIG += lex c++11
+CONFIG += lex c++11 thread
 
 DEFINES += PARSER_LIBRARY
 
@@ -9,6 +9,12 @@ LEXSOURCES += anna.l
 
 SOURCES += parser.cpp \
     lex_helper.cpp \
+    prescan.cpp \
+    stringpool.cpp \
+    tokenbuffer.cpp \
+    nodearena.cpp \
+    flatsyntaxtree.cpp \
+    syntaxcloner.cpp \
     lexertoken.cpp \
     annasyntax.cpp \
     annatoken.cpp \
@@ -20,11 +26,19 @@ SOURCES += parser.cpp \
 HEADERS += parser.h\
         parser_global.h \
     lex_helper.h \
+    prescan.h \
+    stringpool.h \
+    tokenbuffer.h \
+    nodearena.h \
+    flatsyntaxtree.h \
+    syntaxcloner.h \
     lexertoken.h \
     annasyntax.h \
     annatoken.h \
     annasyntaxvisitor.h \
     annanode.h \
+    annaswitchvisitor.h \
+    syntaxchildren.h \
     annanode_forward.h
 
 OTHER_FILES += anna.ebnf
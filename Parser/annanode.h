@@ -26,8 +26,48 @@
 #ifndef ANNANODE_H
 #define ANNANODE_H
 
+#include <cstdint>
+
 #include "annasyntaxvisitor.h"
 
+// The concrete node and token classes
+enum class AnnaNodeKind : uint8_t
+{
+    EOS,
+    CompilationUnit,
+    ImportDirective,
+    FunctionIdentifier,
+    BinaryOperationExpression,
+    SimpleName,
+    Literal,
+    ParenthesizedExpression,
+    BinaryOperator,
+    InvocationExpression,
+    ArgumentList,
+    FunctionDefinition,
+    FunctionHeader,
+    FormalParameterList,
+    FunctionBody,
+    Block,
+    VariableDeclarationStatement,
+    EmptyStatement,
+    ExpressionStatement,
+    StatementExpression,
+    IfStatement,
+    WhileStatement,
+    Assignment,
+    FormalParameter,
+    ReturnStatement,
+    Error,
+
+    Token,
+    IdentifierToken,
+    RealToken,
+    IntegerToken,
+    BooleanToken,
+    StringToken
+};
+
 ///////////
 // Base //
 //////////
@@ -36,8 +76,14 @@ class AnnaNode
 public:
     virtual void Accept(AnnaSyntaxVisitor &visitor);
 
+    // The concrete class, for switching on without a virtual call
+    AnnaNodeKind kind() const { return _kind; }
+
 protected:
+    explicit AnnaNode(AnnaNodeKind kind) : _kind(kind) {}
 
+    // Free on tokens, which pack their fields behind it; a word on syntax nodes
+    AnnaNodeKind _kind;
 };
 
 #endif // ANNANODE_H
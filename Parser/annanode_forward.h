@@ -64,39 +64,43 @@ class AnnaWhileStatementSyntax;
 class AnnaAssignmentSyntax;
 class AnnaFormalParameterSyntax;
 class AnnaReturnStatementSyntax;
+class AnnaErrorSyntax;
 
-typedef std::shared_ptr<AnnaEOSSyntax> gcnEOS;
+// Nodes and tokens are owned by the NodeArena of their compilation unit,
+// which a gcnCompilationUnit keeps alive
+typedef AnnaEOSSyntax *gcnEOS;
 typedef std::shared_ptr<AnnaCompilationUnitSyntax> gcnCompilationUnit;
-typedef std::shared_ptr<AnnaImportDirectiveSyntax> gcnImportDirective;
-typedef std::shared_ptr<AnnaFunctionIdentifierSyntax> gcnFunctionIdentifier;
-typedef std::shared_ptr<AnnaExpressionSyntax> gcnExpression;
-typedef std::shared_ptr<AnnaBinaryOperationExpressionSyntax> gcnBinaryOperationExpression;
-typedef std::shared_ptr<AnnaUnaryExpressionSyntax> gcnUnaryExpression;
-typedef std::shared_ptr<AnnaPrimaryExpressionSyntax> gcnPrimaryExpression;
-typedef std::shared_ptr<AnnaSimpleNameSyntax> gcnSimpleName;
-typedef std::shared_ptr<AnnaLiteralSyntax> gcnLiteral;
-typedef std::shared_ptr<AnnaParenthesizedExpressionSyntax> gcnParenthesizedExpression;
-typedef std::shared_ptr<AnnaBinaryOperatorSyntax> gcnBinaryOperator;
-typedef std::shared_ptr<AnnaInvocationExpressionSyntax> gcnInvocationExpression;
-typedef std::shared_ptr<AnnaArgumentListSyntax> gcnArgumentList;
-typedef std::shared_ptr<AnnaFunctionDefinitionSyntax> gcnFunctionDefinition;
-typedef std::shared_ptr<AnnaFunctionHeaderSyntax> gcnFunctionHeader;
-typedef std::shared_ptr<AnnaFormalParameterListSyntax> gcnFormalParameterList;
-typedef std::shared_ptr<AnnaFunctionBodySyntax> gcnFunctionBody;
-typedef std::shared_ptr<AnnaBlockSyntax> gcnBlock;
-typedef std::shared_ptr<AnnaStatementSyntax> gcnStatement;
-typedef std::shared_ptr<AnnaEmbeddedStatementSyntax> gcnEmbeddedStatement;
-typedef std::shared_ptr<AnnaVariableDeclarationStatementSyntax> gcnVariableDeclarationStatement;
-typedef std::shared_ptr<AnnaEmptyStatementSyntax> gcnEmptyStatement;
-typedef std::shared_ptr<AnnaExpressionStatementSyntax> gcnExpressionStatement;
-typedef std::shared_ptr<AnnaStatementExpressionSyntax> gcnStatementExpression;
-typedef std::shared_ptr<AnnaSelectionStatementSyntax> gcnSelectionStatement;
-typedef std::shared_ptr<AnnaIfStatementSyntax> gcnIfStatement;
-typedef std::shared_ptr<AnnaIterationStatementSyntax> gcnIterationStatement;
-typedef std::shared_ptr<AnnaWhileStatementSyntax> gcnWhileStatement;
-typedef std::shared_ptr<AnnaAssignmentSyntax> gcnAssignment;
-typedef std::shared_ptr<AnnaFormalParameterSyntax> gcnFormalParameter;
-typedef std::shared_ptr<AnnaReturnStatementSyntax> gcnReturnStatement;
+typedef AnnaImportDirectiveSyntax *gcnImportDirective;
+typedef AnnaFunctionIdentifierSyntax *gcnFunctionIdentifier;
+typedef AnnaExpressionSyntax *gcnExpression;
+typedef AnnaBinaryOperationExpressionSyntax *gcnBinaryOperationExpression;
+typedef AnnaUnaryExpressionSyntax *gcnUnaryExpression;
+typedef AnnaPrimaryExpressionSyntax *gcnPrimaryExpression;
+typedef AnnaSimpleNameSyntax *gcnSimpleName;
+typedef AnnaLiteralSyntax *gcnLiteral;
+typedef AnnaParenthesizedExpressionSyntax *gcnParenthesizedExpression;
+typedef AnnaBinaryOperatorSyntax *gcnBinaryOperator;
+typedef AnnaInvocationExpressionSyntax *gcnInvocationExpression;
+typedef AnnaArgumentListSyntax *gcnArgumentList;
+typedef AnnaFunctionDefinitionSyntax *gcnFunctionDefinition;
+typedef AnnaFunctionHeaderSyntax *gcnFunctionHeader;
+typedef AnnaFormalParameterListSyntax *gcnFormalParameterList;
+typedef AnnaFunctionBodySyntax *gcnFunctionBody;
+typedef AnnaBlockSyntax *gcnBlock;
+typedef AnnaStatementSyntax *gcnStatement;
+typedef AnnaEmbeddedStatementSyntax *gcnEmbeddedStatement;
+typedef AnnaVariableDeclarationStatementSyntax *gcnVariableDeclarationStatement;
+typedef AnnaEmptyStatementSyntax *gcnEmptyStatement;
+typedef AnnaExpressionStatementSyntax *gcnExpressionStatement;
+typedef AnnaStatementExpressionSyntax *gcnStatementExpression;
+typedef AnnaSelectionStatementSyntax *gcnSelectionStatement;
+typedef AnnaIfStatementSyntax *gcnIfStatement;
+typedef AnnaIterationStatementSyntax *gcnIterationStatement;
+typedef AnnaWhileStatementSyntax *gcnWhileStatement;
+typedef AnnaAssignmentSyntax *gcnAssignment;
+typedef AnnaFormalParameterSyntax *gcnFormalParameter;
+typedef AnnaReturnStatementSyntax *gcnReturnStatement;
+typedef AnnaErrorSyntax *gcnError;
 
 // Tokens
 class AnnaToken;
@@ -107,13 +111,13 @@ class BooleanToken;
 class StringToken;
 class LiteralToken;
 
-typedef std::shared_ptr<AnnaToken>          gcnToken;
-typedef std::shared_ptr<IdentifierToken>    gcnIdentifierToken;
-typedef std::shared_ptr<RealToken>          gcnRealToken;
-typedef std::shared_ptr<IntegerToken>       gcnIntegerToken;
-typedef std::shared_ptr<BooleanToken>       gcnBooleanToken;
-typedef std::shared_ptr<StringToken>        gcnStringToken;
-typedef std::shared_ptr<LiteralToken>       gcnLiteralToken;
+typedef AnnaToken           *gcnToken;
+typedef IdentifierToken     *gcnIdentifierToken;
+typedef RealToken           *gcnRealToken;
+typedef IntegerToken        *gcnIntegerToken;
+typedef BooleanToken        *gcnBooleanToken;
+typedef StringToken         *gcnStringToken;
+typedef LiteralToken        *gcnLiteralToken;
 
 
 #endif // ANNANODE_FORWARD
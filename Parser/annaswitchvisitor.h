@@ -0,0 +1,169 @@
+/**************************************************************************
+ * Copyright (c) 2015 Afa.L Cheng <afa@afa.moe>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ***************************************************************************/
+
+
+#ifndef ANNASWITCHVISITOR_H
+#define ANNASWITCHVISITOR_H
+
+#include "annasyntax.h"
+
+// Dispatches on AnnaNode::kind() with a switch instead of Accept(), so
+// calls to the visit functions of Derived can be inlined. Derived hides
+// the visitX() it handles; the others fall back to visitNode(). A pass
+// can skip a subtree by not visiting its children, or by testing kind()
+// before calling visit().
+//
+//   class Counter : public AnnaSwitchVisitor<Counter>
+//   {
+//   public:
+//       void visitInvocationExpression(AnnaInvocationExpressionSyntax &node);
+//   };
+template <typename Derived, typename Result = void>
+class AnnaSwitchVisitor
+{
+public:
+    Result visit(AnnaNode &node)
+    {
+        Derived &self = static_cast<Derived &>(*this);
+
+        switch (node.kind()) {
+            case AnnaNodeKind::EOS:
+                return self.visitEOS(static_cast<AnnaEOSSyntax &>(node));
+            case AnnaNodeKind::CompilationUnit:
+                return self.visitCompilationUnit(static_cast<AnnaCompilationUnitSyntax &>(node));
+            case AnnaNodeKind::ImportDirective:
+                return self.visitImportDirective(static_cast<AnnaImportDirectiveSyntax &>(node));
+            case AnnaNodeKind::FunctionIdentifier:
+                return self.visitFunctionIdentifier(static_cast<AnnaFunctionIdentifierSyntax &>(node));
+            case AnnaNodeKind::BinaryOperationExpression:
+                return self.visitBinaryOperationExpression(static_cast<AnnaBinaryOperationExpressionSyntax &>(node));
+            case AnnaNodeKind::SimpleName:
+                return self.visitSimpleName(static_cast<AnnaSimpleNameSyntax &>(node));
+            case AnnaNodeKind::Literal:
+                return self.visitLiteral(static_cast<AnnaLiteralSyntax &>(node));
+            case AnnaNodeKind::ParenthesizedExpression:
+                return self.visitParenthesizedExpression(static_cast<AnnaParenthesizedExpressionSyntax &>(node));
+            case AnnaNodeKind::BinaryOperator:
+                return self.visitBinaryOperator(static_cast<AnnaBinaryOperatorSyntax &>(node));
+            case AnnaNodeKind::InvocationExpression:
+                return self.visitInvocationExpression(static_cast<AnnaInvocationExpressionSyntax &>(node));
+            case AnnaNodeKind::ArgumentList:
+                return self.visitArgumentList(static_cast<AnnaArgumentListSyntax &>(node));
+            case AnnaNodeKind::FunctionDefinition:
+                return self.visitFunctionDefinition(static_cast<AnnaFunctionDefinitionSyntax &>(node));
+            case AnnaNodeKind::FunctionHeader:
+                return self.visitFunctionHeader(static_cast<AnnaFunctionHeaderSyntax &>(node));
+            case AnnaNodeKind::FormalParameterList:
+                return self.visitFormalParameterList(static_cast<AnnaFormalParameterListSyntax &>(node));
+            case AnnaNodeKind::FunctionBody:
+                return self.visitFunctionBody(static_cast<AnnaFunctionBodySyntax &>(node));
+            case AnnaNodeKind::Block:
+                return self.visitBlock(static_cast<AnnaBlockSyntax &>(node));
+            case AnnaNodeKind::VariableDeclarationStatement:
+                return self.visitVariableDeclarationStatement(static_cast<AnnaVariableDeclarationStatementSyntax &>(node));
+            case AnnaNodeKind::EmptyStatement:
+                return self.visitEmptyStatement(static_cast<AnnaEmptyStatementSyntax &>(node));
+            case AnnaNodeKind::ExpressionStatement:
+                return self.visitExpressionStatement(static_cast<AnnaExpressionStatementSyntax &>(node));
+            case AnnaNodeKind::StatementExpression:
+                return self.visitStatementExpression(static_cast<AnnaStatementExpressionSyntax &>(node));
+            case AnnaNodeKind::IfStatement:
+                return self.visitIfStatement(static_cast<AnnaIfStatementSyntax &>(node));
+            case AnnaNodeKind::WhileStatement:
+                return self.visitWhileStatement(static_cast<AnnaWhileStatementSyntax &>(node));
+            case AnnaNodeKind::Assignment:
+                return self.visitAssignment(static_cast<AnnaAssignmentSyntax &>(node));
+            case AnnaNodeKind::FormalParameter:
+                return self.visitFormalParameter(static_cast<AnnaFormalParameterSyntax &>(node));
+            case AnnaNodeKind::ReturnStatement:
+                return self.visitReturnStatement(static_cast<AnnaReturnStatementSyntax &>(node));
+            case AnnaNodeKind::Error:
+                return self.visitError(static_cast<AnnaErrorSyntax &>(node));
+            case AnnaNodeKind::Token:
+                return self.visitToken(static_cast<AnnaToken &>(node));
+            case AnnaNodeKind::IdentifierToken:
+                return self.visitIdentifierToken(static_cast<IdentifierToken &>(node));
+            case AnnaNodeKind::RealToken:
+                return self.visitRealToken(static_cast<RealToken &>(node));
+            case AnnaNodeKind::IntegerToken:
+                return self.visitIntegerToken(static_cast<IntegerToken &>(node));
+            case AnnaNodeKind::BooleanToken:
+                return self.visitBooleanToken(static_cast<BooleanToken &>(node));
+            case AnnaNodeKind::StringToken:
+                return self.visitStringToken(static_cast<StringToken &>(node));
+        }
+
+        return self.visitNode(node);
+    }
+
+    Result visitNode(AnnaNode &node)
+    {
+        (void)node;
+        return Result();
+    }
+
+    // Syntax Nodes
+    Result visitEOS(AnnaEOSSyntax &node) { return fallback(node); }
+    Result visitCompilationUnit(AnnaCompilationUnitSyntax &node) { return fallback(node); }
+    Result visitImportDirective(AnnaImportDirectiveSyntax &node) { return fallback(node); }
+    Result visitFunctionIdentifier(AnnaFunctionIdentifierSyntax &node) { return fallback(node); }
+    Result visitBinaryOperationExpression(AnnaBinaryOperationExpressionSyntax &node) { return fallback(node); }
+    Result visitSimpleName(AnnaSimpleNameSyntax &node) { return fallback(node); }
+    Result visitLiteral(AnnaLiteralSyntax &node) { return fallback(node); }
+    Result visitParenthesizedExpression(AnnaParenthesizedExpressionSyntax &node) { return fallback(node); }
+    Result visitBinaryOperator(AnnaBinaryOperatorSyntax &node) { return fallback(node); }
+    Result visitInvocationExpression(AnnaInvocationExpressionSyntax &node) { return fallback(node); }
+    Result visitArgumentList(AnnaArgumentListSyntax &node) { return fallback(node); }
+    Result visitFunctionDefinition(AnnaFunctionDefinitionSyntax &node) { return fallback(node); }
+    Result visitFunctionHeader(AnnaFunctionHeaderSyntax &node) { return fallback(node); }
+    Result visitFormalParameterList(AnnaFormalParameterListSyntax &node) { return fallback(node); }
+    Result visitFunctionBody(AnnaFunctionBodySyntax &node) { return fallback(node); }
+    Result visitBlock(AnnaBlockSyntax &node) { return fallback(node); }
+    Result visitVariableDeclarationStatement(AnnaVariableDeclarationStatementSyntax &node) { return fallback(node); }
+    Result visitEmptyStatement(AnnaEmptyStatementSyntax &node) { return fallback(node); }
+    Result visitExpressionStatement(AnnaExpressionStatementSyntax &node) { return fallback(node); }
+    Result visitStatementExpression(AnnaStatementExpressionSyntax &node) { return fallback(node); }
+    Result visitIfStatement(AnnaIfStatementSyntax &node) { return fallback(node); }
+    Result visitWhileStatement(AnnaWhileStatementSyntax &node) { return fallback(node); }
+    Result visitAssignment(AnnaAssignmentSyntax &node) { return fallback(node); }
+    Result visitFormalParameter(AnnaFormalParameterSyntax &node) { return fallback(node); }
+    Result visitReturnStatement(AnnaReturnStatementSyntax &node) { return fallback(node); }
+    Result visitError(AnnaErrorSyntax &node) { return fallback(node); }
+
+    // Tokens
+    Result visitToken(AnnaToken &node) { return fallback(node); }
+    Result visitIdentifierToken(IdentifierToken &node) { return fallback(node); }
+    Result visitRealToken(RealToken &node) { return fallback(node); }
+    Result visitIntegerToken(IntegerToken &node) { return fallback(node); }
+    Result visitBooleanToken(BooleanToken &node) { return fallback(node); }
+    Result visitStringToken(StringToken &node) { return fallback(node); }
+
+protected:
+    AnnaSwitchVisitor() {}
+
+private:
+    Result fallback(AnnaNode &node) { return static_cast<Derived &>(*this).visitNode(node); }
+};
+
+#endif // ANNASWITCHVISITOR_H
@@ -40,6 +40,7 @@ class AnnaSyntax : public AnnaNode
 public:
 
 protected:
+    explicit AnnaSyntax(AnnaNodeKind kind) : AnnaNode(kind) {}
 
 };
 
@@ -53,7 +54,7 @@ class AnnaSeperatedList
 public:
     AnnaSeperatedList()
     {
-        static_assert(std::is_base_of<AnnaSyntax, typename T::element_type>::value, "AnnaSeperatedList takes only AnnaSyntax");
+        static_assert(std::is_base_of<AnnaSyntax, typename std::remove_pointer<T>::type>::value, "AnnaSeperatedList takes only AnnaSyntax");
     }
 
     void add(T node)
@@ -76,8 +77,8 @@ public:
 
 //protected:
     struct Couple {
-        T node;
-        gcnToken COMMA;
+        T node = nullptr;
+        gcnToken COMMA = nullptr;
     };
 
     std::vector<Couple> list;
@@ -90,7 +91,7 @@ public:
 class AnnaEOSSyntax : public AnnaSyntax
 {
 public:
-    AnnaEOSSyntax(const std::vector<gcnToken> &Ts) : T(Ts) {}
+    AnnaEOSSyntax(const std::vector<gcnToken> &Ts) : AnnaSyntax(AnnaNodeKind::EOS), T(Ts) {}
     void Accept(AnnaSyntaxVisitor &visitor);
 
 //protected:
@@ -103,9 +104,12 @@ public:
     AnnaCompilationUnitSyntax(const std::vector<gcnImportDirective> &imp,
                               const std::vector<gcnVariableDeclarationStatement> &vard,
                               const std::vector<gcnFunctionDefinition> &funcd,
-                              gcString name) :
+                              gcString name,
+                              const std::vector<gcnError> &errs = std::vector<gcnError>(),
+                              const std::vector<AnnaSyntax *> &decls = std::vector<AnnaSyntax *>()) :
+        AnnaSyntax(AnnaNodeKind::CompilationUnit),
         importDirectives(imp), variableDeclarationStatements(vard), functionDefinitions(funcd),
-        compilationUnitName(name)
+        errors(errs), declarations(decls), compilationUnitName(name)
     {}
     void Accept(AnnaSyntaxVisitor &visitor);
 
@@ -113,6 +117,10 @@ public:
     std::vector<gcnImportDirective> importDirectives;
     std::vector<gcnVariableDeclarationStatement> variableDeclarationStatements;
     std::vector<gcnFunctionDefinition> functionDefinitions;
+    // Declarations that failed to parse
+    std::vector<gcnError> errors;
+    // All of the above, in source order
+    std::vector<AnnaSyntax *> declarations;
     gcString compilationUnitName;
 };
 
@@ -120,14 +128,15 @@ class AnnaImportDirectiveSyntax : public AnnaSyntax
 {
 public:
     AnnaImportDirectiveSyntax(gcnToken import, gcnIdentifierToken id, gcnEOS e) :
+        AnnaSyntax(AnnaNodeKind::ImportDirective),
         IMPORT(import), IDENTIFIER(id), eos(e)
     {}
     void Accept(AnnaSyntaxVisitor &visitor);
 
 //protected:
-    gcnToken IMPORT;
-    gcnIdentifierToken IDENTIFIER;
-    gcnEOS eos;
+    gcnToken IMPORT = nullptr;
+    gcnIdentifierToken IDENTIFIER = nullptr;
+    gcnEOS eos = nullptr;
 };
 
 //////////////
@@ -137,12 +146,13 @@ class AnnaFunctionDefinitionSyntax : public AnnaSyntax
 {
 public:
     AnnaFunctionDefinitionSyntax(gcnFunctionHeader header, gcnFunctionBody body) :
+        AnnaSyntax(AnnaNodeKind::FunctionDefinition),
         functionHeader(header), functionBody(body) {}
     void Accept(AnnaSyntaxVisitor &visitor);
 
 //protected:
-    gcnFunctionHeader functionHeader;
-    gcnFunctionBody functionBody;
+    gcnFunctionHeader functionHeader = nullptr;
+    gcnFunctionBody functionBody = nullptr;
 };
 
 class AnnaFunctionHeaderSyntax : public AnnaSyntax
@@ -151,6 +161,7 @@ public:
     AnnaFunctionHeaderSyntax(gcnToken def, gcnIdentifierToken id,
                              gcnToken openPar, gcnFormalParameterList pm,
                              gcnToken closePar) :
+        AnnaSyntax(AnnaNodeKind::FunctionHeader),
         DEF(def), USER_FUNCTION_IDENTIFIER(id), OPEN_PAREN(openPar),
         formalParameterList_opt(pm), CLOSE_PAREN(closePar), hasParameter(true)
     {}
@@ -158,16 +169,17 @@ public:
     AnnaFunctionHeaderSyntax(gcnToken def, gcnIdentifierToken id,
                              gcnToken openPar,
                              gcnToken closePar) :
+        AnnaSyntax(AnnaNodeKind::FunctionHeader),
         DEF(def), USER_FUNCTION_IDENTIFIER(id), OPEN_PAREN(openPar),
         CLOSE_PAREN(closePar), hasParameter(false) {}
     void Accept(AnnaSyntaxVisitor &visitor);
 
 //protected:
-    gcnToken DEF;
-    gcnIdentifierToken USER_FUNCTION_IDENTIFIER;
-    gcnToken OPEN_PAREN;
-    gcnFormalParameterList formalParameterList_opt;
-    gcnToken CLOSE_PAREN;
+    gcnToken DEF = nullptr;
+    gcnIdentifierToken USER_FUNCTION_IDENTIFIER = nullptr;
+    gcnToken OPEN_PAREN = nullptr;
+    gcnFormalParameterList formalParameterList_opt = nullptr;
+    gcnToken CLOSE_PAREN = nullptr;
 
     bool hasParameter;
 };
@@ -176,17 +188,19 @@ public:
 class AnnaFormalParameterSyntax : public AnnaSyntax
 {
 public:
-    AnnaFormalParameterSyntax(gcnIdentifierToken id) : VARIABLE_IDENTIFIER(id) {}
+    AnnaFormalParameterSyntax(gcnIdentifierToken id) :
+        AnnaSyntax(AnnaNodeKind::FormalParameter), VARIABLE_IDENTIFIER(id) {}
     void Accept(AnnaSyntaxVisitor &visitor);
 
 //protected:
-    gcnIdentifierToken VARIABLE_IDENTIFIER;
+    gcnIdentifierToken VARIABLE_IDENTIFIER = nullptr;
 };
 
 class AnnaFormalParameterListSyntax : public AnnaSyntax
 {
 public:
     AnnaFormalParameterListSyntax(AnnaSeperatedList<gcnFormalParameter> list) :
+        AnnaSyntax(AnnaNodeKind::FormalParameterList),
         formalParameterList(list) {}
     void Accept(AnnaSyntaxVisitor &visitor);
 
@@ -197,21 +211,22 @@ public:
 class AnnaFunctionBodySyntax : public AnnaSyntax
 {
 public:
-    AnnaFunctionBodySyntax(gcnBlock bl) : block(bl) {}
+    AnnaFunctionBodySyntax(gcnBlock bl) : AnnaSyntax(AnnaNodeKind::FunctionBody), block(bl) {}
     void Accept(AnnaSyntaxVisitor &visitor);
 
 //protected:
-    gcnBlock block;
+    gcnBlock block = nullptr;
 };
 
 class AnnaFunctionIdentifierSyntax : public AnnaSyntax
 {
 public:
-    AnnaFunctionIdentifierSyntax(gcnIdentifierToken id) : identifier(id) {}
+    AnnaFunctionIdentifierSyntax(gcnIdentifierToken id) :
+        AnnaSyntax(AnnaNodeKind::FunctionIdentifier), identifier(id) {}
     void Accept(AnnaSyntaxVisitor &visitor);
 
 //protected:
-    gcnIdentifierToken identifier;
+    gcnIdentifierToken identifier = nullptr;
 };
 
 ////////////////
@@ -222,7 +237,7 @@ class AnnaExpressionSyntax : public AnnaSyntax
 public:
 
 protected:
-    AnnaExpressionSyntax() {}
+    explicit AnnaExpressionSyntax(AnnaNodeKind kind) : AnnaSyntax(kind) {}
 };
 
 class AnnaBinaryOperationExpressionSyntax : public AnnaExpressionSyntax
@@ -230,77 +245,82 @@ class AnnaBinaryOperationExpressionSyntax : public AnnaExpressionSyntax
 public:
     AnnaBinaryOperationExpressionSyntax(gcnExpression l, gcnBinaryOperator o,
                                         gcnExpression r) :
+        AnnaExpressionSyntax(AnnaNodeKind::BinaryOperationExpression),
         left(l), op(o), right(r) {}
     void Accept(AnnaSyntaxVisitor &visitor);
 
 //protected:
-    gcnExpression left;
-    gcnBinaryOperator op;
-    gcnExpression right;
+    gcnExpression left = nullptr;
+    gcnBinaryOperator op = nullptr;
+    gcnExpression right = nullptr;
 };
 
 class AnnaUnaryExpressionSyntax : public AnnaExpressionSyntax
 {
 public:
 protected:
-    AnnaUnaryExpressionSyntax() {}
+    explicit AnnaUnaryExpressionSyntax(AnnaNodeKind kind) : AnnaExpressionSyntax(kind) {}
 };
 
 class AnnaPrimaryExpressionSyntax : public AnnaUnaryExpressionSyntax
 {
 public:
 protected:
-    AnnaPrimaryExpressionSyntax() {}
+    explicit AnnaPrimaryExpressionSyntax(AnnaNodeKind kind) : AnnaUnaryExpressionSyntax(kind) {}
 };
 
 class AnnaSimpleNameSyntax : public AnnaPrimaryExpressionSyntax
 {
 public:
-    AnnaSimpleNameSyntax(gcnToken tok) : VARIABLE_IDENTIFIER(tok) {}
+    AnnaSimpleNameSyntax(gcnToken tok) :
+        AnnaPrimaryExpressionSyntax(AnnaNodeKind::SimpleName), VARIABLE_IDENTIFIER(tok) {}
     void Accept(AnnaSyntaxVisitor &visitor);
 
 //protected:
-    gcnToken VARIABLE_IDENTIFIER;
+    gcnToken VARIABLE_IDENTIFIER = nullptr;
 };
 
 class AnnaLiteralSyntax : public AnnaPrimaryExpressionSyntax
 {
 public:
-    AnnaLiteralSyntax(gcnLiteralToken tok) : literal(tok) {}
+    AnnaLiteralSyntax(gcnLiteralToken tok) :
+        AnnaPrimaryExpressionSyntax(AnnaNodeKind::Literal), literal(tok) {}
     void Accept(AnnaSyntaxVisitor &visitor);
 
 //protected:
     // STRING | REAL | INTEGER | BOOLEAN
-    gcnLiteralToken literal;
+    gcnLiteralToken literal = nullptr;
 };
 
 class AnnaParenthesizedExpressionSyntax : public AnnaPrimaryExpressionSyntax
 {
 public:
     AnnaParenthesizedExpressionSyntax(gcnToken lpa, gcnExpression exp, gcnToken rpa) :
+        AnnaPrimaryExpressionSyntax(AnnaNodeKind::ParenthesizedExpression),
         OPEN_PAREN(lpa), expression(exp), CLOSE_PAREN(rpa) {}
     void Accept(AnnaSyntaxVisitor &visitor);
 
 //protected:
-    gcnToken OPEN_PAREN;
-    gcnExpression expression;
-    gcnToken CLOSE_PAREN;
+    gcnToken OPEN_PAREN = nullptr;
+    gcnExpression expression = nullptr;
+    gcnToken CLOSE_PAREN = nullptr;
 };
 
 class AnnaBinaryOperatorSyntax : public AnnaSyntax
 {
 public:
-    AnnaBinaryOperatorSyntax(gcnToken op) : binOp(op) {}
+    AnnaBinaryOperatorSyntax(gcnToken op) : AnnaSyntax(AnnaNodeKind::BinaryOperator), binOp(op) {}
     void Accept(AnnaSyntaxVisitor &visitor);
 
 //protected:
-    gcnToken binOp;
+    gcnToken binOp = nullptr;
 };
 
 class AnnaArgumentListSyntax : public AnnaSyntax
 {
 public:
     AnnaArgumentListSyntax(const AnnaSeperatedList<gcnExpression> &list) :
+        AnnaSyntax(AnnaNodeKind::ArgumentList),
         argumentList(list) {}
     void Accept(AnnaSyntaxVisitor &visitor);
 
@@ -315,30 +335,44 @@ class AnnaStatementSyntax : public AnnaSyntax
 {
 public:
 protected:
-    AnnaStatementSyntax() {}
+    explicit AnnaStatementSyntax(AnnaNodeKind kind) : AnnaSyntax(kind) {}
+};
+
+// Tokens skipped while recovering from a syntax error
+class AnnaErrorSyntax : public AnnaStatementSyntax
+{
+public:
+    AnnaErrorSyntax(const std::vector<gcnToken> &skipped) :
+        AnnaStatementSyntax(AnnaNodeKind::Error), tokens(skipped) {}
+    void Accept(AnnaSyntaxVisitor &visitor);
+
+//protected:
+    std::vector<gcnToken> tokens;
 };
 
 class AnnaVariableDeclarationStatementSyntax : public AnnaStatementSyntax
 {
 public:
     AnnaVariableDeclarationStatementSyntax(gcnToken var, gcnIdentifierToken id, gcnEOS eos) :
+        AnnaStatementSyntax(AnnaNodeKind::VariableDeclarationStatement),
         VAR(var), VARIABLE_IDENTIFIER(id), EOS(eos), hasAssignment(false) {}
 
     AnnaVariableDeclarationStatementSyntax(gcnToken var, gcnIdentifierToken id,
                                            gcnToken eq, gcnPrimaryExpression pe,
                                            gcnEOS eos) :
+        AnnaStatementSyntax(AnnaNodeKind::VariableDeclarationStatement),
         VAR(var), VARIABLE_IDENTIFIER(id), EOS(eos),
         EQ_opt(eq), primaryExpression_opt(pe), hasAssignment(true) {}
 
     void Accept(AnnaSyntaxVisitor &visitor);
 
 //protected:
-    gcnToken VAR;
-    gcnIdentifierToken VARIABLE_IDENTIFIER;
-    gcnEOS EOS;
+    gcnToken VAR = nullptr;
+    gcnIdentifierToken VARIABLE_IDENTIFIER = nullptr;
+    gcnEOS EOS = nullptr;
 
-    gcnToken EQ_opt;
-    gcnPrimaryExpression primaryExpression_opt;
+    gcnToken EQ_opt = nullptr;
+    gcnPrimaryExpression primaryExpression_opt = nullptr;
     bool hasAssignment;
 };
 
@@ -346,22 +380,24 @@ class AnnaEmbeddedStatementSyntax : public AnnaStatementSyntax
 {
 public:
 protected:
-    AnnaEmbeddedStatementSyntax() {}
+    explicit AnnaEmbeddedStatementSyntax(AnnaNodeKind kind) : AnnaStatementSyntax(kind) {}
 };
 
 class AnnaReturnStatementSyntax : public AnnaEmbeddedStatementSyntax
 {
 public:
     AnnaReturnStatementSyntax(gcnToken ret, gcnExpression expr, gcnEOS e) :
+        AnnaEmbeddedStatementSyntax(AnnaNodeKind::ReturnStatement),
         RETURN(ret), expression(expr), eos(e), hasExpr(true) {}
     AnnaReturnStatementSyntax(gcnToken ret, gcnEOS e) :
+        AnnaEmbeddedStatementSyntax(AnnaNodeKind::ReturnStatement),
         RETURN(ret), eos(e), hasExpr(false) {}
     void Accept(AnnaSyntaxVisitor &visitor);
 
 //protected:
-    gcnToken RETURN;
-    gcnExpression expression;
-    gcnEOS eos;
+    gcnToken RETURN = nullptr;
+    gcnExpression expression = nullptr;
+    gcnEOS eos = nullptr;
     bool hasExpr;
 };
 
@@ -370,24 +406,27 @@ class AnnaBlockSyntax : public AnnaEmbeddedStatementSyntax
 {
 public:
     AnnaBlockSyntax(gcnToken openBra, const std::vector<gcnStatement> &stmts, gcnToken closeBra) :
+        AnnaEmbeddedStatementSyntax(AnnaNodeKind::Block),
         OPEN_BRACE(openBra), statements(stmts), CLOSE_BRACE(closeBra) {}
     void Accept(AnnaSyntaxVisitor &visitor);
 
 //protected:
-    gcnToken OPEN_BRACE;
+    gcnToken OPEN_BRACE = nullptr;
     std::vector<gcnStatement> statements;
-    gcnToken CLOSE_BRACE;
+    gcnToken CLOSE_BRACE = nullptr;
 };
 
 class AnnaEmptyStatementSyntax : public AnnaEmbeddedStatementSyntax
 {
 public:
-    AnnaEmptyStatementSyntax() : has_eos(false) {}
-    AnnaEmptyStatementSyntax(gcnEOS eos) : eos_opt(eos), has_eos(true) {}
+    AnnaEmptyStatementSyntax() :
+        AnnaEmbeddedStatementSyntax(AnnaNodeKind::EmptyStatement), has_eos(false) {}
+    AnnaEmptyStatementSyntax(gcnEOS eos) :
+        AnnaEmbeddedStatementSyntax(AnnaNodeKind::EmptyStatement), eos_opt(eos), has_eos(true) {}
     void Accept(AnnaSyntaxVisitor &visitor);
 
 //protected:
-    gcnEOS eos_opt;
+    gcnEOS eos_opt = nullptr;
     bool has_eos;
 };
 
@@ -395,7 +434,7 @@ class AnnaSelectionStatementSyntax : public AnnaEmbeddedStatementSyntax
 {
 public:
 protected:
-    AnnaSelectionStatementSyntax() {}
+    explicit AnnaSelectionStatementSyntax(AnnaNodeKind kind) : AnnaEmbeddedStatementSyntax(kind) {}
 };
 
 class AnnaIfStatementSyntax : public AnnaSelectionStatementSyntax
@@ -403,25 +442,27 @@ class AnnaIfStatementSyntax : public AnnaSelectionStatementSyntax
 public:
     AnnaIfStatementSyntax(gcnToken _if, gcnToken openP, gcnExpression expr,
                           gcnToken closeP, gcnEmbeddedStatement stat) :
+        AnnaSelectionStatementSyntax(AnnaNodeKind::IfStatement),
         IF(_if), OPEN_PAREN(openP), condition(expr), CLOSE_PAREN(closeP),
         embeddedStatement(stat), hasElse(false) {}
     AnnaIfStatementSyntax(gcnToken _if, gcnToken openP, gcnExpression expr,
                           gcnToken closeP, gcnEmbeddedStatement stat,
                           gcnToken _else, gcnEmbeddedStatement elseStat) :
+        AnnaSelectionStatementSyntax(AnnaNodeKind::IfStatement),
         IF(_if), OPEN_PAREN(openP), condition(expr), CLOSE_PAREN(closeP),
         embeddedStatement(stat), ELSE_opt(_else), elseStatement_opt(elseStat),
         hasElse(true) {}
     void Accept(AnnaSyntaxVisitor &visitor);
 
 //protected:
-    gcnToken IF;
-    gcnToken OPEN_PAREN;
-    gcnExpression condition;
-    gcnToken CLOSE_PAREN;
-    gcnEmbeddedStatement embeddedStatement;
-
-    gcnToken ELSE_opt;
-    gcnEmbeddedStatement elseStatement_opt;
+    gcnToken IF = nullptr;
+    gcnToken OPEN_PAREN = nullptr;
+    gcnExpression condition = nullptr;
+    gcnToken CLOSE_PAREN = nullptr;
+    gcnEmbeddedStatement embeddedStatement = nullptr;
+
+    gcnToken ELSE_opt = nullptr;
+    gcnEmbeddedStatement elseStatement_opt = nullptr;
     bool hasElse;
 };
 
@@ -429,19 +470,20 @@ class AnnaExpressionStatementSyntax : public AnnaEmbeddedStatementSyntax
 {
 public:
     AnnaExpressionStatementSyntax(gcnStatementExpression expr, gcnEOS e) :
+        AnnaEmbeddedStatementSyntax(AnnaNodeKind::ExpressionStatement),
         statementExpression(expr), eos(e) {}
     void Accept(AnnaSyntaxVisitor &visitor);
 
 //protected:
-    gcnStatementExpression statementExpression;
-    gcnEOS eos;
+    gcnStatementExpression statementExpression = nullptr;
+    gcnEOS eos = nullptr;
 };
 
 class AnnaIterationStatementSyntax : public AnnaEmbeddedStatementSyntax
 {
 public:
 protected:
-    AnnaIterationStatementSyntax() {}
+    explicit AnnaIterationStatementSyntax(AnnaNodeKind kind) : AnnaEmbeddedStatementSyntax(kind) {}
 };
 
 class AnnaWhileStatementSyntax : public AnnaIterationStatementSyntax
@@ -449,69 +491,88 @@ class AnnaWhileStatementSyntax : public AnnaIterationStatementSyntax
 public:
     AnnaWhileStatementSyntax(gcnToken whi, gcnToken openPar, gcnExpression cond,
                              gcnToken closePar, gcnEmbeddedStatement body) :
+        AnnaIterationStatementSyntax(AnnaNodeKind::WhileStatement),
         WHILE(whi), OPEN_PAREN(openPar), condition(cond), CLOSE_PAREN(closePar),
         while_body(body) {}
     void Accept(AnnaSyntaxVisitor &visitor);
 
 //protected:
-    gcnToken WHILE;
-    gcnToken OPEN_PAREN;
-    gcnExpression condition;
-    gcnToken CLOSE_PAREN;
-    gcnEmbeddedStatement while_body;
+    gcnToken WHILE = nullptr;
+    gcnToken OPEN_PAREN = nullptr;
+    gcnExpression condition = nullptr;
+    gcnToken CLOSE_PAREN = nullptr;
+    gcnEmbeddedStatement while_body = nullptr;
 };
 
-class AnnaStatementExpressionSyntax : public AnnaSyntax
-{
-public:
-protected:
-    AnnaStatementExpressionSyntax() {}
-};
-
-class AnnaInvocationExpressionSyntax : public AnnaPrimaryExpressionSyntax, virtual public AnnaStatementExpressionSyntax
+class AnnaInvocationExpressionSyntax : public AnnaPrimaryExpressionSyntax
 {
 public:
     AnnaInvocationExpressionSyntax(gcnFunctionIdentifier id, gcnToken opPar,
                                    gcnArgumentList args, gcnToken clPar) :
+        AnnaPrimaryExpressionSyntax(AnnaNodeKind::InvocationExpression),
         functionIdentifier(id), OPEN_PAREN_opt(opPar), argumentList(args),
         CLOSE_PAREN_opt(clPar), hasOptionalPar(true), hasArgs(true) {}
 
     AnnaInvocationExpressionSyntax(gcnFunctionIdentifier id, gcnToken opPar,
                                    gcnToken clPar) :
+        AnnaPrimaryExpressionSyntax(AnnaNodeKind::InvocationExpression),
         functionIdentifier(id), OPEN_PAREN_opt(opPar), CLOSE_PAREN_opt(clPar),
         hasOptionalPar(true), hasArgs(false) {}
 
     AnnaInvocationExpressionSyntax(gcnFunctionIdentifier id, gcnArgumentList args) :
+        AnnaPrimaryExpressionSyntax(AnnaNodeKind::InvocationExpression),
         functionIdentifier(id), argumentList(args), hasOptionalPar(false),
         hasArgs(true) {}
 
     AnnaInvocationExpressionSyntax(gcnFunctionIdentifier id) :
+        AnnaPrimaryExpressionSyntax(AnnaNodeKind::InvocationExpression),
         functionIdentifier(id), hasOptionalPar(false), hasArgs(false) {}
     void Accept(AnnaSyntaxVisitor &visitor);
 
 //protected:
-    gcnFunctionIdentifier functionIdentifier;
+    gcnFunctionIdentifier functionIdentifier = nullptr;
 
-    gcnToken OPEN_PAREN_opt;
-    gcnArgumentList argumentList;
-    gcnToken CLOSE_PAREN_opt;
+    gcnToken OPEN_PAREN_opt = nullptr;
+    gcnArgumentList argumentList = nullptr;
+    gcnToken CLOSE_PAREN_opt = nullptr;
 
     bool hasOptionalPar;
     bool hasArgs;
 };
 
 
-class AnnaAssignmentSyntax : public AnnaStatementExpressionSyntax, virtual public AnnaExpressionSyntax
+class AnnaAssignmentSyntax : public AnnaExpressionSyntax
 {
 public:
     AnnaAssignmentSyntax(gcnSimpleName l, gcnToken eq, gcnExpression r) :
+        AnnaExpressionSyntax(AnnaNodeKind::Assignment),
         left(l), EQ(eq), right(r) {}
     void Accept(AnnaSyntaxVisitor &visitor);
 
 //protected:
-    gcnSimpleName left;
-    gcnToken EQ;
-    gcnExpression right;
+    gcnSimpleName left = nullptr;
+    gcnToken EQ = nullptr;
+    gcnExpression right = nullptr;
+};
+
+// An invocation or an assignment used as a statement
+class AnnaStatementExpressionSyntax : public AnnaSyntax
+{
+public:
+    AnnaStatementExpressionSyntax(gcnInvocationExpression invocation) :
+        AnnaSyntax(AnnaNodeKind::StatementExpression),
+        invocationExpression_opt(invocation), isAssignment(false) {}
+
+    AnnaStatementExpressionSyntax(gcnAssignment assign) :
+        AnnaSyntax(AnnaNodeKind::StatementExpression),
+        assignment_opt(assign), isAssignment(true) {}
+    void Accept(AnnaSyntaxVisitor &visitor);
+
+//protected:
+    gcnInvocationExpression invocationExpression_opt = nullptr;
+    gcnAssignment assignment_opt = nullptr;
+
+    bool isAssignment;
 };
 
 
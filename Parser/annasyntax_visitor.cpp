@@ -134,6 +134,11 @@ void AnnaAssignmentSyntax::Accept(AnnaSyntaxVisitor &visitor)
     visitor.Visit(*this);
 }
 
+void AnnaStatementExpressionSyntax::Accept(AnnaSyntaxVisitor &visitor)
+{
+    visitor.Visit(*this);
+}
+
 void AnnaFormalParameterSyntax::Accept(AnnaSyntaxVisitor &visitor)
 {
     visitor.Visit(*this);
@@ -143,3 +148,8 @@ void AnnaReturnStatementSyntax::Accept(AnnaSyntaxVisitor &visitor)
 {
     visitor.Visit(*this);
 }
+
+void AnnaErrorSyntax::Accept(AnnaSyntaxVisitor &visitor)
+{
+    visitor.Visit(*this);
+}
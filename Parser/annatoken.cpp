@@ -24,6 +24,126 @@
 
 
 #include "annatoken.h"
+#include "nodearena.h"
+
+static const char *const token_spellings[] = {
+    "def", "main", "if", "else", "while",
+    ">=", "<=", "==", "!=", "&", "|", "^", ">", "<",
+    "+", "-", "*", "/", "%", "!", "~", "&&", "||", "=",
+    "import", "return", "var",
+    "user function identifier", "identifier", "variable identifier",
+    "string", "real", "integer", "boolean",
+    ";", "(", ")", "{", "}", "[", "]", ",",
+};
+
+static const size_t token_spelling_count = sizeof(token_spellings) / sizeof(token_spellings[0]);
+
+const char *AnnaToken::spelling(Tokens token)
+{
+    if (token == END)
+        return "EOF";
+    if (token == ERROR)
+        return "error";
+
+    size_t index = token - DEF;
+    return index < token_spelling_count ? token_spellings[index] : "";
+}
+
+const gcString &AnnaToken::spellingText(Tokens token)
+{
+    // Built once and shared by every token of the kind
+    static const std::vector<gcString> texts = [] {
+        std::vector<gcString> v;
+        for (size_t i = 0; i < token_spelling_count; ++i)
+            v.push_back(std::make_shared<std::string>(token_spellings[i]));
+        return v;
+    }();
+    static const gcString endText = std::make_shared<std::string>(spelling(END));
+    static const gcString errorText = std::make_shared<std::string>(spelling(ERROR));
+    static const gcString noText = std::make_shared<std::string>();
+
+    if (token == END)
+        return endText;
+    if (token == ERROR)
+        return errorText;
+
+    size_t index = token - DEF;
+    return index < token_spelling_count ? texts[index] : noText;
+}
+
+const gcString &AnnaToken::newlineText()
+{
+    static const gcString text = std::make_shared<std::string>("\n");
+    return text;
+}
+
+const std::string &AnnaToken::text() const
+{
+    switch (_kind) {
+        case AnnaNodeKind::IdentifierToken:
+            return *static_cast<const IdentifierToken *>(this)->identifier();
+        case AnnaNodeKind::RealToken:
+        case AnnaNodeKind::IntegerToken:
+        case AnnaNodeKind::BooleanToken:
+        case AnnaNodeKind::StringToken:
+            return *static_cast<const LiteralToken *>(this)->_text;
+        default:
+            return _newline ? *newlineText() : *spellingText(token());
+    }
+}
+
+const TokenComments &AnnaToken::trailingComments() const
+{
+    static const TokenComments none;
+    return _trailing_comments ? *_trailing_comments : none;
+}
+
+AnnaToken *AnnaToken::clone(NodeArena &arena, int lines) const
+{
+    const TokenComments *comments = nullptr;
+    if (_trailing_comments)
+        comments = arena.make<TokenComments>(*_trailing_comments);
+
+    int row = _row + lines;
+    switch (_kind) {
+        case AnnaNodeKind::IdentifierToken: {
+            const IdentifierToken &self = static_cast<const IdentifierToken &>(*this);
+            return arena.make<IdentifierToken>(token(), row, _col, width(), self.identifier(), comments);
+        }
+        case AnnaNodeKind::RealToken: {
+            const RealToken &self = static_cast<const RealToken &>(*this);
+            return arena.make<RealToken>(token(), row, _col, width(), self._text, self.real(), comments);
+        }
+        case AnnaNodeKind::IntegerToken: {
+            const IntegerToken &self = static_cast<const IntegerToken &>(*this);
+            return arena.make<IntegerToken>(token(), row, _col, width(), self._text, self.integer(), comments);
+        }
+        case AnnaNodeKind::BooleanToken: {
+            const BooleanToken &self = static_cast<const BooleanToken &>(*this);
+            return arena.make<BooleanToken>(token(), row, _col, width(), self._text, self.boolean(), comments);
+        }
+        case AnnaNodeKind::StringToken: {
+            const StringToken &self = static_cast<const StringToken &>(*this);
+            return arena.make<StringToken>(token(), row, _col, width(), self._text, comments);
+        }
+        default:
+            return arena.make<AnnaToken>(token(), row, _col, width(), comments, _newline);
+    }
+}
+
+LiteralToken::LiteralType LiteralToken::literalType() const
+{
+    switch (_kind) {
+        case AnnaNodeKind::RealToken:
+            return Real;
+        case AnnaNodeKind::IntegerToken:
+            return Integer;
+        case AnnaNodeKind::BooleanToken:
+            return Boolean;
+        default:
+            return String;
+    }
+}
 
 void AnnaToken::Accept(AnnaSyntaxVisitor &visitor)
 {
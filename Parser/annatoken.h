@@ -30,6 +30,7 @@
 #include "annanode.h"
 #include "annasyntaxvisitor.h"
 
+class NodeArena;
 
 enum Tokens
 {
@@ -80,46 +81,75 @@ enum Tokens
     ERROR = -1
 };
 
+// Comments attached to a token, owned by the arena of its tree
+typedef std::vector<std::string> TokenComments;
+
+// Tokens are the bulk of a tree, so they are kept small: fixed text is
+// recovered from the kind, and comments are out of line.
 class AnnaToken : public AnnaNode
 {
 public:
-    AnnaToken(Tokens token, gcString text, int row, int col,
-              int width, std::vector<std::string> trailingComments = std::vector<std::string>())
-        : _token(token), _text(text), _row(row),
-          _col(col), _width(width), _trailing_comments(trailingComments)
-    {}
+    // newline marks a T that is a line break rather than a `;'
+    AnnaToken(Tokens token, int row, int col, int width,
+              const TokenComments *trailingComments = nullptr, bool newline = false)
+        : AnnaToken(AnnaNodeKind::Token, token, row, col, width, trailingComments)
+    {
+        _newline = newline;
+    }
+
+    AnnaToken(const AnnaToken &) = delete;
+    AnnaToken &operator=(const AnnaToken &) = delete;
 
     virtual void Accept(AnnaSyntaxVisitor &visitor);
 
-    Tokens token() { return _token; }
-    gcString text() { return _text; }
-    int row() { return _row; }
-    int col() { return _col; }
-    int width() { return _width; }
-    std::vector<std::string> trailingComments() { return _trailing_comments; }
+    Tokens token() const { return static_cast<Tokens>(_token); }
+    const std::string &text() const;
+    int row() const { return _row; }
+    int col() const { return _col; }
+    int width() const { return static_cast<int>(_width); }
+    const TokenComments &trailingComments() const;
+
+    // A copy in arena, with its comments, lines rows further down
+    AnnaToken *clone(NodeArena &arena, int lines) const;
+
+    // Fixed spelling of a token kind; tokens of these kinds carry no text
+    // of their own. T is spelled ";", a newline T uses newlineText().
+    static const char *spelling(Tokens token);
+    static const gcString &spellingText(Tokens token);
+    static const gcString &newlineText();
 
 protected:
-    Tokens _token;
+    AnnaToken(AnnaNodeKind kind, Tokens token, int row, int col, int width,
+              const TokenComments *trailingComments)
+        : AnnaNode(kind), _newline(false), _token(static_cast<int16_t>(token)),
+          _width(static_cast<uint32_t>(width)), _row(row), _col(col),
+          _trailing_comments(trailingComments)
+    {}
 
-    gcString _text;
+    bool _newline;
+    int16_t _token;
+    uint32_t _width;
     int _row;
     int _col;
-    int _width;
-    std::vector<std::string> _trailing_comments;
+    // Null when there are none
+    const TokenComments *_trailing_comments;
 };
 
 class IdentifierToken : public AnnaToken
 {
 public:
-    IdentifierToken(Tokens token, gcString text, int row, int col, int width, gcString identifier,
-                    std::vector<std::string> trailingComments = std::vector<std::string>())
-        : AnnaToken(token, text, row, col, width, trailingComments), _identifier(identifier)
+    IdentifierToken(Tokens token, int row, int col, int width, gcString identifier,
+                    const TokenComments *trailingComments = nullptr)
+        : AnnaToken(AnnaNodeKind::IdentifierToken, token, row, col, width, trailingComments),
+          _identifier(std::move(identifier))
     {}
 
     virtual void Accept(AnnaSyntaxVisitor &visitor);
 
 
-    gcString identifier() { return _identifier; }
+    // Interned by the lexer: equal identifiers from one parser share a
+    // string, so they can be compared by pointer.
+    const gcString &identifier() const { return _identifier; }
 
 protected:
     gcString _identifier;
@@ -137,30 +167,32 @@ public:
 
     virtual void Accept(AnnaSyntaxVisitor &visitor);
 
-    LiteralType literalType();
+    LiteralType literalType() const;
 
 protected:
-    LiteralToken(Tokens token, gcString text, int row, int col, int width,
-                 std::vector<std::string> trailingComments = std::vector<std::string>())
-        : AnnaToken(token, text, row, col, width, trailingComments)
+    LiteralToken(AnnaNodeKind kind, Tokens token, int row, int col, int width, gcString text,
+                 const TokenComments *trailingComments)
+        : AnnaToken(kind, token, row, col, width, trailingComments), _text(std::move(text))
     {}
 
-    LiteralType _literalType;
+    friend class AnnaToken;
+
+    // As written in the source
+    gcString _text;
 };
 
 class RealToken : public LiteralToken
 {
 public:
-    RealToken(Tokens token, gcString text, int row, int col, int width, double real,
-                    std::vector<std::string> trailingComments = std::vector<std::string>())
-        : LiteralToken(token, text, row, col, width, trailingComments), _real(real)
-    {
-         _literalType = Real;
-    }
+    RealToken(Tokens token, int row, int col, int width, gcString text, double real,
+              const TokenComments *trailingComments = nullptr)
+        : LiteralToken(AnnaNodeKind::RealToken, token, row, col, width, std::move(text), trailingComments),
+          _real(real)
+    {}
 
     virtual void Accept(AnnaSyntaxVisitor &visitor);
 
-    double real() { return _real; }
+    double real() const { return _real; }
 
 protected:
     double _real;
@@ -169,16 +201,15 @@ protected:
 class IntegerToken : public LiteralToken
 {
 public:
-    IntegerToken(Tokens token, gcString text, int row, int col, int width, int integer,
-                 std::vector<std::string> trailingComments = std::vector<std::string>())
-        : LiteralToken(token, text, row, col, width, trailingComments), _integer(integer)
-    {
-        _literalType = Integer;
-    }
+    IntegerToken(Tokens token, int row, int col, int width, gcString text, int integer,
+                 const TokenComments *trailingComments = nullptr)
+        : LiteralToken(AnnaNodeKind::IntegerToken, token, row, col, width, std::move(text), trailingComments),
+          _integer(integer)
+    {}
 
     virtual void Accept(AnnaSyntaxVisitor &visitor);
 
-    int integer() { return _integer; }
+    int integer() const { return _integer; }
 
 protected:
     int _integer;
@@ -187,16 +218,15 @@ protected:
 class BooleanToken : public LiteralToken
 {
 public:
-    BooleanToken(Tokens token, gcString text, int row, int col, int width, int boolean,
-                 std::vector<std::string> trailingComments = std::vector<std::string>())
-        : LiteralToken(token, text, row, col, width, trailingComments), _boolean(boolean)
-    {
-        _literalType = Boolean;
-    }
+    BooleanToken(Tokens token, int row, int col, int width, gcString text, int boolean,
+                 const TokenComments *trailingComments = nullptr)
+        : LiteralToken(AnnaNodeKind::BooleanToken, token, row, col, width, std::move(text), trailingComments),
+          _boolean(boolean)
+    {}
 
     virtual void Accept(AnnaSyntaxVisitor &visitor);
 
-    int boolean() { return _boolean; }
+    int boolean() const { return _boolean; }
 
 protected:
     int _boolean;
@@ -205,19 +235,14 @@ protected:
 class StringToken : public LiteralToken
 {
 public:
-    StringToken(Tokens token, gcString text, int row, int col, int width, gcString identifier,
-                    std::vector<std::string> trailingComments = std::vector<std::string>())
-        : LiteralToken(token, text, row, col, width, trailingComments), _string(identifier)
-    {
-         _literalType = String;
-    }
+    StringToken(Tokens token, int row, int col, int width, gcString string,
+                const TokenComments *trailingComments = nullptr)
+        : LiteralToken(AnnaNodeKind::StringToken, token, row, col, width, std::move(string), trailingComments)
+    {}
 
     virtual void Accept(AnnaSyntaxVisitor &visitor);
 
-    gcString string() { return _string; }
-
-protected:
-    gcString _string;
+    const gcString &string() const { return _text; }
 };
 
 
@@ -0,0 +1,82 @@
+/**************************************************************************
+ * Copyright (c) 2015 Afa.L Cheng <afa@afa.moe>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ***************************************************************************/
+
+#include "flatsyntaxtree.h"
+#include "syntaxchildren.h"
+
+const FlatSyntaxTree::Index FlatSyntaxTree::None;
+
+FlatSyntaxTree::FlatSyntaxTree(gcnCompilationUnit unit) : _unit(unit)
+{
+    if (!_unit)
+        return;
+
+    std::vector<AnnaNode *> pending;
+    append(*_unit, None, pending);
+}
+
+// Appends node and its subtree in preorder. The children of a node get
+// their slots in _children before any of them is appended, so siblings
+// stay contiguous; pending holds them meanwhile, as a stack shared by
+// the whole walk.
+FlatSyntaxTree::Index FlatSyntaxTree::append(AnnaNode &node, Index parent, std::vector<AnnaNode *> &pending)
+{
+    Index i = static_cast<Index>(_kinds.size());
+
+    _kinds.push_back(node.kind());
+    _parents.push_back(parent);
+    _ends.push_back(i + 1);
+    _firstChildren.push_back(0);
+    _childCounts.push_back(0);
+    _tokenSlots.push_back(None);
+    _nodes.push_back(&node);
+
+    if (node.kind() >= AnnaNodeKind::Token) {
+        AnnaToken &token = static_cast<AnnaToken &>(node);
+        _tokenSlots[i] = static_cast<Index>(_tokenKinds.size());
+        _tokenKinds.push_back(token.token());
+        _rows.push_back(token.row());
+        _cols.push_back(token.col());
+        _texts.push_back(&token.text());
+        return i;
+    }
+
+    size_t begin = pending.size();
+    forEachChild(node, [&pending](AnnaNode &child) { pending.push_back(&child); });
+
+    uint32_t count = static_cast<uint32_t>(pending.size() - begin);
+    Index first = static_cast<Index>(_children.size());
+    _firstChildren[i] = first;
+    _childCounts[i] = count;
+    _children.resize(_children.size() + count);
+
+    for (uint32_t n = 0; n < count; ++n) {
+        Index child = append(*pending[begin + n], i, pending);
+        _children[first + n] = child;
+    }
+
+    pending.resize(begin);
+    _ends[i] = static_cast<Index>(_kinds.size());
+    return i;
+}
@@ -0,0 +1,94 @@
+/**************************************************************************
+ * Copyright (c) 2015 Afa.L Cheng <afa@afa.moe>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ***************************************************************************/
+
+
+#ifndef FLATSYNTAXTREE_H
+#define FLATSYNTAXTREE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "annasyntax.h"
+
+// A compilation unit laid out as tables indexed by node. Nodes are stored
+// in preorder, so the subtree of node i is [i, end(i)) and a pass over the
+// whole tree is a loop over the indices. Children are ranges into one
+// shared index array, in the order forEachChild() gives them.
+class FlatSyntaxTree
+{
+public:
+    typedef uint32_t Index;
+    static const Index None = UINT32_MAX;
+
+    // Keeps unit, and with it the nodes behind node(), alive
+    explicit FlatSyntaxTree(gcnCompilationUnit unit);
+
+    size_t size() const { return _kinds.size(); }
+    // The compilation unit is node 0; None when there is no unit
+    Index root() const { return _kinds.empty() ? None : 0; }
+    gcnCompilationUnit unit() const { return _unit; }
+
+    AnnaNodeKind kind(Index i) const { return _kinds[i]; }
+    Index parent(Index i) const { return _parents[i]; }
+    Index end(Index i) const { return _ends[i]; }
+
+    uint32_t childCount(Index i) const { return _childCounts[i]; }
+    Index child(Index i, uint32_t n) const { return _children[_firstChildren[i] + n]; }
+    const Index *childrenBegin(Index i) const { return _children.data() + _firstChildren[i]; }
+    const Index *childrenEnd(Index i) const { return childrenBegin(i) + _childCounts[i]; }
+
+    // Token data, for nodes of a token kind
+    bool isToken(Index i) const { return _tokenSlots[i] != None; }
+    Tokens token(Index i) const { return _tokenKinds[_tokenSlots[i]]; }
+    int row(Index i) const { return _rows[_tokenSlots[i]]; }
+    int col(Index i) const { return _cols[_tokenSlots[i]]; }
+    const std::string &text(Index i) const { return *_texts[_tokenSlots[i]]; }
+
+    // The node a row stands for, so that an AnnaSyntaxVisitor can still
+    // be run on any subtree
+    AnnaNode &node(Index i) const { return *_nodes[i]; }
+    void accept(Index i, AnnaSyntaxVisitor &visitor) const { _nodes[i]->Accept(visitor); }
+
+private:
+    Index append(AnnaNode &node, Index parent, std::vector<AnnaNode *> &pending);
+
+    gcnCompilationUnit _unit;
+
+    std::vector<AnnaNodeKind> _kinds;
+    std::vector<Index> _parents;
+    std::vector<Index> _ends;
+    std::vector<Index> _firstChildren;
+    std::vector<uint32_t> _childCounts;
+    std::vector<Index> _tokenSlots;
+    std::vector<AnnaNode *> _nodes;
+
+    std::vector<Index> _children;
+
+    std::vector<Tokens> _tokenKinds;
+    std::vector<int> _rows;
+    std::vector<int> _cols;
+    std::vector<const std::string *> _texts;
+};
+
+#endif // FLATSYNTAXTREE_H
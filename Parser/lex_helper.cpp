@@ -22,64 +22,276 @@
  *
  ***************************************************************************/
 
+#include <cerrno>
 #include <cstring>
 #include <cstdio>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include "lexertoken.h"
 #include "lex_helper.h"
+#include "prescan.h"
 #include "parser.h"
 
-extern FILE* yyin;
-int yylex();
-static bool use_temp_file_stream;
-static std::string __lex_filename;
+int yylex_init_extra(LexerContext *user_defined, yyscan_t *scanner);
+int yylex_destroy(yyscan_t scanner);
+int yylex(yyscan_t scanner);
 
-static void split_lines(FILE* in)
+LexerContext::LexerContext()
 {
-    std::vector<std::string>& source_rows = get_lex_source_rows();
+}
 
+LexerContext::~LexerContext()
+{
+    finalize();
+}
+
+// False on a read error. Reads interrupted by a signal are retried.
+static bool read_all(FILE *in, std::string &text)
+{
     char buf[65536];
-    long current_pos = ftell(in);
-    char* line;
-    do {
-        line = fgets(buf, 65536, in);
-        source_rows.push_back(std::string(buf));
-    } while (line);
-    fseek(in, current_pos, SEEK_SET);
+    for (;;) {
+        errno = 0;
+        size_t n = std::fread(buf, 1, sizeof(buf), in);
+        text.append(buf, n);
+        if (n == sizeof(buf))
+            continue;
+
+        if (!std::ferror(in))
+            return true;
+        if (errno != EINTR)
+            return false;
+        std::clearerr(in);
+    }
 }
 
-bool lexer_init(FILE* in, const std::string &filename)
+bool LexerContext::init(FILE* in, const std::string &filename)
 {
-    lexer_finalize();
+    finalize();
+
+    _filename = filename;
 
-    use_temp_file_stream = false;
-    yyin = in;
-    split_lines(in);
+    // Read the stream once; the scanner and error reporting share the text
+    if (!read_all(in, _fileText)) {
+        std::fprintf(__log_out, "Cannot read from %s\n", filename.c_str());
+        return false;
+    }
+    _memory = _fileText.data();
+    _memoryLength = _fileText.size();
 
-    __lex_filename = filename;
+    yylex_init_extra(this, &_scanner);
     return true;
 }
 
-bool lexer_init(char* in, size_t len, const std::string &filename)
+bool LexerContext::init(const char* in, size_t len, const std::string &filename)
 {
-    lexer_finalize();
+    finalize();
 
-    use_temp_file_stream = true;
-    yyin = tmpfile();
-    fwrite(in, 1, len, yyin);
-    fseek(yyin, 0, SEEK_SET);
-    split_lines(yyin);
+    _memory = in;
+    _memoryLength = len;
 
-    __lex_filename = filename;
+    yylex_init_extra(this, &_scanner);
+
+    _filename = filename;
     return true;
 }
 
-gcnToken tokenize()
+bool LexerContext::init(const std::string &path)
 {
-    int lex_val = yylex();
+    finalize();
 
-    auto tComments = lexerToken.trailing_comments;
-    lexerToken.trailing_comments.clear();
+    _filename = path;
+    if (!mapFile(path)) {
+        std::fprintf(__log_out, "Cannot open file %s\n", path.c_str());
+        return false;
+    }
+
+    yylex_init_extra(this, &_scanner);
+    return true;
+}
+
+#ifdef _WIN32
+bool LexerContext::mapFile(const std::string &path)
+{
+    // No mmap here; read the file once and scan it from memory
+    FILE *f = std::fopen(path.c_str(), "rb");
+    if (!f)
+        return false;
+
+    bool read = read_all(f, _fileText);
+    std::fclose(f);
+    if (!read)
+        return false;
+
+    _memory = _fileText.data();
+    _memoryLength = _fileText.size();
+    return true;
+}
+
+void LexerContext::unmapFile()
+{
+}
+#else
+bool LexerContext::mapFile(const std::string &path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return false;
+    }
+
+    if (st.st_size > 0) {
+        void *mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+        _mapped = mapped;
+        _mappedLength = st.st_size;
+    }
+    close(fd);
+
+    _memory = static_cast<const char *>(_mapped);
+    _memoryLength = _mappedLength;
+    return true;
+}
+
+void LexerContext::unmapFile()
+{
+    if (_mapped)
+        munmap(_mapped, _mappedLength);
+    _mapped = nullptr;
+    _mappedLength = 0;
+}
+#endif
+
+void LexerContext::edit(size_t offset, size_t removed, const std::string &inserted)
+{
+    if (_memory != _fileText.data()) {
+        _fileText.assign(_memory, _memoryLength);
+        unmapFile();
+    }
+
+    _fileText.replace(offset, removed, inserted);
+    _memory = _fileText.data();
+    _memoryLength = _fileText.size();
+
+    _lineStarts.clear();
+    _lineIndexBuilt = false;
+}
+
+void LexerContext::restart(size_t offset, int row, int col)
+{
+    if (_scanner)
+        yylex_destroy(_scanner);
+    yylex_init_extra(this, &_scanner);
+
+    _memoryPos = offset;
+    _currentOffset = offset;
+    _currentRow = row;
+    _currentColumn = col;
+    lexerToken.clear();
+    COMS_start = 0;
+}
+
+// Skipping a comment throws away what the scanner has buffered past it,
+// so it is handed the source in small chunks
+static const size_t read_chunk = 1024;
+
+size_t LexerContext::readInput(char *buf, size_t maxSize)
+{
+    size_t n = std::min(std::min(maxSize, read_chunk), _memoryLength - _memoryPos);
+    // An empty file is not mapped, so there may be no memory at all
+    if (n == 0)
+        return 0;
+
+    std::memcpy(buf, _memory + _memoryPos, n);
+    _memoryPos += n;
+    return n;
+}
+
+void LexerContext::advanceToken(int leng)
+{
+    lexerToken.token_row = _currentRow;
+    lexerToken.token_col = _currentColumn;
+    lexerToken.token_leng = leng;
+    lexerToken.token_offset = _currentOffset;
+    lexerToken.text.reset();
+    _currentColumn += leng;
+    _currentOffset += leng;
+}
+
+void LexerContext::advanceText(const char *text, int leng)
+{
+    advanceToken(leng);
+    lexerToken.text = _strings.intern(text, leng);
+}
+
+void LexerContext::advanceRow(int leng)
+{
+    advanceToken(leng);
+    lexerToken.text = AnnaToken::newlineText();
+    ++_currentRow;
+    _currentColumn = 0;
+}
+
+void LexerContext::advanceSpan(const char *text, int leng)
+{
+    advanceToken(leng);
+
+    const char *lastNewline = nullptr;
+    size_t rows = prescan_newlines(text, text + leng, &lastNewline);
+    if (rows) {
+        _currentRow += static_cast<int>(rows);
+        _currentColumn = static_cast<int>(text + leng - lastNewline - 1);
+    }
+}
+
+bool LexerContext::skipComment(int leng)
+{
+    if (!_prescan)
+        return false;
+
+    // The match starts at the current offset. A comment left open runs to
+    // the end of the source and is dropped, as the COMS states do.
+    const char *begin = _memory + _currentOffset;
+    const char *end = _memory + _memoryLength;
+    const char *close = prescan_comment_end(begin + leng, end);
+
+    advanceSpan(begin, static_cast<int>((close ? close : end) - begin));
+    if (close) {
+        COMS_start = lexerToken.token_offset;
+        endComment();
+    }
+
+    _memoryPos = _currentOffset;
+    return true;
+}
+
+void LexerContext::endComment()
+{
+    lexerToken.trailing_comments.push_back(SourceSpan{COMS_start, _currentOffset - COMS_start});
+}
+
+Tokens LexerContext::scan(TokenBuffer &tokens)
+{
+    int lex_val = yylex(_scanner);
+    Tokens kind = static_cast<Tokens>(lex_val);
+
+    uint32_t offset = static_cast<uint32_t>(lexerToken.token_offset);
+    uint32_t length = static_cast<uint32_t>(lexerToken.token_leng);
+    int row = lexerToken.token_row;
+    int col = lexerToken.token_col;
 
     switch (lex_val) {
         case DEF:
@@ -116,93 +328,113 @@ gcnToken tokenize()
         case OPEN_BRACKET:
         case CLOSE_BRACKET:
         case COMMA:
+            tokens.append(kind, offset, length, row, col);
+            break;
         case T:
-            return std::make_shared<AnnaToken>(static_cast<Tokens>(lex_val),
-                                               lexerToken.text,
-                                               lexerToken.token_row,
-                                               lexerToken.token_col,
-                                               lexerToken.token_leng,
-                                               tComments);
+            tokens.append(kind, offset, length, row, col, lexerToken.text == AnnaToken::newlineText());
+            break;
 
         case USER_FUNCTION_IDENTIFIER:
         case IDENTIFIER:
         case VARIABLE_IDENTIFIER:
-            return std::make_shared<IdentifierToken>(static_cast<Tokens>(lex_val),
-                                                     lexerToken.text,
-                                                     lexerToken.token_row,
-                                                     lexerToken.token_col,
-                                                     lexerToken.token_leng,
-                                                     lexerToken.identifier,
-                                                     tComments);
         case STRING:
-            return std::make_shared<StringToken>(static_cast<Tokens>(lex_val),
-                                                 lexerToken.text,
-                                                 lexerToken.token_row,
-                                                 lexerToken.token_col,
-                                                 lexerToken.token_leng,
-                                                 lexerToken.string,
-                                                 tComments);
+            tokens.appendText(kind, offset, length, row, col, lexerToken.text);
+            break;
         case REAL:
-            return std::make_shared<RealToken>(static_cast<Tokens>(lex_val),
-                                               lexerToken.text,
-                                               lexerToken.token_row,
-                                               lexerToken.token_col,
-                                               lexerToken.token_leng,
-                                               lexerToken.real,
-                                               tComments);
+            tokens.appendReal(offset, length, row, col, lexerToken.text, lexerToken.real);
+            break;
         case INTEGER:
-            return std::make_shared<IntegerToken>(static_cast<Tokens>(lex_val),
-                                                  lexerToken.text,
-                                                  lexerToken.token_row,
-                                                  lexerToken.token_col,
-                                                  lexerToken.token_leng,
-                                                  lexerToken.integer,
-                                                  tComments);
+            tokens.appendInteger(offset, length, row, col, lexerToken.text, lexerToken.integer);
+            break;
         case BOOLEAN:
-            return std::make_shared<BooleanToken>(static_cast<Tokens>(lex_val),
-                                                  lexerToken.text,
-                                                  lexerToken.token_row,
-                                                  lexerToken.token_col,
-                                                  lexerToken.token_leng,
-                                                  lexerToken.boolean,
-                                                  tComments);
+            tokens.appendBoolean(offset, length, row, col, lexerToken.text, lexerToken.boolean);
+            break;
         case 0:
-            return std::make_shared<AnnaToken>(END,
-                                               lexerToken.text,
-                                               lexerToken.token_row,
-                                               lexerToken.token_col,
-                                               lexerToken.token_leng,
-                                               tComments);
+            kind = END;
+            break;
         case ERROR:
-            log_print_pos(lexerToken.token_row, lexerToken.token_col, __lex_filename);
+            log_print_pos(lexerToken.token_row, lexerToken.token_col, _filename);
             std::fprintf(__log_out, "Unrecognized token ``%s''\n", lexerToken.text->c_str());
-            log_print_row(lexerToken.token_row);
+            printRow(lexerToken.token_row);
             log_print_indicators(lexerToken.token_col, lexerToken.token_leng);
-            return std::make_shared<AnnaToken>(ERROR,
-                                               lexerToken.text,
-                                               lexerToken.token_row,
-                                               lexerToken.token_col,
-                                               lexerToken.token_leng,
-                                               tComments);
             break;
         default:
             throw;  // Should not happen
             break;
     }
+
+    // Comments scanned before a token are attached to it
+    if (kind > 0) {
+        for (const SourceSpan &comment : lexerToken.trailing_comments)
+            tokens.appendComment(tokens.end() - 1, comment.offset, comment.length);
+    }
+    lexerToken.trailing_comments.clear();
+
+    return kind;
+}
+
+void LexerContext::finalize()
+{
+    if (_scanner) {
+        yylex_destroy(_scanner);
+        _scanner = nullptr;
+    }
+
+    unmapFile();
+    _fileText.clear();
+    _memory = nullptr;
+    _memoryLength = 0;
+    _memoryPos = 0;
+
+    lexerToken.clear();
+    COMS_start = 0;
+    _strings.clear();
+    _lineStarts.clear();
+    _lineIndexBuilt = false;
+    _currentRow = 0;
+    _currentColumn = 0;
+    _currentOffset = 0;
+}
+
+void LexerContext::buildLineIndex()
+{
+    const char *begin = _memory;
+    const char *end = _memory + _memoryLength;
+    const char *p = begin;
+
+    _lineStarts.push_back(0);
+    while (p < end) {
+        const char *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+        if (!eol)
+            break;
+        p = eol + 1;
+        _lineStarts.push_back(p - begin);
+    }
+    _lineIndexBuilt = true;
 }
 
-void lexer_finalize()
+StringRef LexerContext::sourceRow(int row)
 {
-    if (use_temp_file_stream)
-        fclose(yyin);
+    // Rows are only needed for diagnostics, so index them on first use
+    if (!_lineIndexBuilt)
+        buildLineIndex();
+
+    if (row < 0 || static_cast<size_t>(row) >= _lineStarts.size())
+        return StringRef();
+
+    size_t start = _lineStarts[row];
+    size_t end = static_cast<size_t>(row) + 1 < _lineStarts.size() ? _lineStarts[row + 1] : _memoryLength;
+    return StringRef(_memory + start, end - start);
 }
 
-void log_print_row(int row)
+void LexerContext::printRow(int row)
 {
-    std::fputs(get_lex_source_row(row).c_str(), __log_out);
+    StringRef line = sourceRow(row);
+    std::fwrite(line.data(), 1, line.size(), __log_out);
 }
 
-void log_print_row(int row, std::stringstream &logstream)
+void LexerContext::printRow(int row, std::stringstream &logstream)
 {
-    logstream << get_lex_source_row(row).c_str();
+    StringRef line = sourceRow(row);
+    logstream.write(line.data(), line.size());
 }
@@ -27,17 +27,107 @@
 #define LEX_HELPER_H
 
 #include <cstdio>
+#include <sstream>
 
 #include "annatoken.h"
+#include "lexertoken.h"
+#include "stringpool.h"
+#include "tokenbuffer.h"
 
-bool lexer_init(FILE *in, const std::string &filename);
-bool lexer_init(char *in, size_t len, const std::string &filename);
-void lexer_finalize();
-std::string get_lex_source_row(int row);
-std::vector<std::string> &get_lex_source_rows();
-gcnToken tokenize();
-void log_print_row(int row);
-void log_print_row(int row, std::stringstream &logstream);
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void *yyscan_t;
+#endif
+
+// Per-instance lexer state. Each AnnaParser owns one, so independent
+// parsers never share scanner buffers, positions or source rows.
+class LexerContext
+{
+public:
+    LexerContext();
+    ~LexerContext();
+
+    LexerContext(const LexerContext &) = delete;
+    LexerContext &operator=(const LexerContext &) = delete;
+
+    // False when the stream cannot be read
+    bool init(FILE *in, const std::string &filename);
+    // The buffer is not copied as a whole and must outlive the context;
+    // readInput() copies it into the scanner's buffer a chunk at a time.
+    bool init(const char *in, size_t len, const std::string &filename);
+    // Maps the file at path into memory and scans from the mapping
+    bool init(const std::string &path);
+    void finalize();
+
+    // Replaces removed bytes at offset with inserted. A source the
+    // context does not own is copied first.
+    void edit(size_t offset, size_t removed, const std::string &inserted);
+    // Starts scanning again at offset, which must not be inside a token
+    // or comment, counting from row and col
+    void restart(size_t offset, int row, int col);
+
+    // Scans the next token into tokens and returns its kind. END and
+    // ERROR are returned without being appended.
+    Tokens scan(TokenBuffer &tokens);
+    // Where a token ends can depend on up to this many characters after
+    // it: `50US' is read before `50' is taken as an integer because no
+    // `D' follows. The rules in anna.l must keep to this.
+    static const size_t MaxLookahead = 3;
+
+    StringRef sourceRow(int row);
+    void printRow(int row);
+    void printRow(int row, std::stringstream &logstream);
+
+    // Used by scanner actions and YY_INPUT
+    size_t readInput(char *buf, size_t maxSize);
+    // Only identifiers, literals and unrecognized input keep their text;
+    // other tokens are spelled from AnnaToken::spelling()
+    void advanceToken(int leng);
+    void advanceText(const char *text, int leng);
+    void advanceRow(int leng);
+    // Advances past text that may span several rows
+    void advanceSpan(const char *text, int leng);
+    // Called with the opening -_- of a comment just matched. Finds the end
+    // of the comment in the source with prescan_comment_end(), records it,
+    // and makes readInput() continue after it; the scanner must then be
+    // flushed. False, with nothing done, when the fast path is disabled.
+    bool skipComment(int leng);
+    // Enables the skipComment() fast path; on by default
+    void setPrescan(bool enabled) { _prescan = enabled; }
+
+    gcString intern(const char *text, size_t len) { return _strings.intern(text, len); }
+
+    // Records the comment from COMS_start up to the current position
+    void endComment();
+    const char *source() const { return _memory; }
+    size_t sourceLength() const { return _memoryLength; }
+
+    LexerToken lexerToken;
+    size_t COMS_start = 0;
+
+private:
+    void buildLineIndex();
+    bool mapFile(const std::string &path);
+    void unmapFile();
+
+    yyscan_t _scanner = nullptr;
+    const char *_memory = nullptr;
+    size_t _memoryLength = 0;
+    size_t _memoryPos = 0;
+    bool _prescan = true;
+    std::string _fileText;
+    void *_mapped = nullptr;
+    size_t _mappedLength = 0;
+    std::string _filename;
+    StringPool _strings;
+
+    int _currentRow = 0;
+    int _currentColumn = 0;
+    size_t _currentOffset = 0;
+    // Offset of the first character of each row, built on demand
+    std::vector<size_t> _lineStarts;
+    bool _lineIndexBuilt = false;
+};
 
 #endif // LEX_HELPER_H
 
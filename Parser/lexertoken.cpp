@@ -33,10 +33,9 @@ void LexerToken::clear()
     token_col = 0;
     token_row = 0;
     token_leng = 0;
+    token_offset = 0;
 
     string.reset();
     identifier.reset();
     trailing_comments.clear();
 }
-
-LexerToken lexerToken;
@@ -28,6 +28,13 @@
 
 #include "parser_global.h"
 
+// A range of the source text
+struct SourceSpan
+{
+    size_t offset;
+    size_t length;
+};
+
 class LexerToken
 {
 public:
@@ -37,17 +44,17 @@ public:
     gcString string;
     gcString identifier;
 
-    std::vector<std::string> trailing_comments;
+    // Comments scanned since the previous token
+    std::vector<SourceSpan> trailing_comments;
 
     int token_row;
     int token_col;
     int token_leng;
+    size_t token_offset;
     gcString text;
 
     void clear();
 };
 
-extern LexerToken lexerToken;
-
 
 #endif // LEXERTOKEN_H
@@ -0,0 +1,60 @@
+/**************************************************************************
+ * Copyright (c) 2015 Afa.L Cheng <afa@afa.moe>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ***************************************************************************/
+
+#include <algorithm>
+#include <cstdint>
+
+#include "nodearena.h"
+
+// Large enough that a chunk holds a few thousand nodes
+static const size_t chunk_size = 64 * 1024;
+
+NodeArena::~NodeArena()
+{
+    for (auto it = _destructors.rbegin(); it != _destructors.rend(); ++it)
+        it->destroy(it->object);
+}
+
+void NodeArena::adopt(const std::shared_ptr<NodeArena> &other)
+{
+    if (other.get() == this || std::find(_adopted.begin(), _adopted.end(), other) != _adopted.end())
+        return;
+    _adopted.push_back(other);
+}
+
+void *NodeArena::allocate(size_t size, size_t align)
+{
+    uintptr_t next = (reinterpret_cast<uintptr_t>(_next) + align - 1) & ~static_cast<uintptr_t>(align - 1);
+    if (!_next || next + size > reinterpret_cast<uintptr_t>(_end)) {
+        // Oversized objects get a chunk of their own
+        size_t length = std::max(chunk_size, size + align);
+        _chunks.emplace_back(new char[length]);
+        _next = _chunks.back().get();
+        _end = _next + length;
+        next = (reinterpret_cast<uintptr_t>(_next) + align - 1) & ~static_cast<uintptr_t>(align - 1);
+    }
+
+    _next = reinterpret_cast<char *>(next + size);
+    return reinterpret_cast<void *>(next);
+}
@@ -0,0 +1,81 @@
+/**************************************************************************
+ * Copyright (c) 2015 Afa.L Cheng <afa@afa.moe>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ***************************************************************************/
+
+#ifndef NODEARENA_H
+#define NODEARENA_H
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Owns the syntax nodes and tokens of a compilation unit. Objects are
+// bump-allocated from large chunks and freed together with the arena;
+// only those with non-trivial destructors are destroyed one by one.
+class NodeArena
+{
+public:
+    NodeArena() {}
+    ~NodeArena();
+
+    NodeArena(const NodeArena &) = delete;
+    NodeArena &operator=(const NodeArena &) = delete;
+
+    template <typename T, typename... Args>
+    T *make(Args &&... args)
+    {
+        T *object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        if (!std::is_trivially_destructible<T>::value)
+            _destructors.push_back(Destructor{object, &destroy<T>});
+        return object;
+    }
+
+    // Keeps other alive as long as this arena, for objects of other that
+    // this arena's objects point to
+    void adopt(const std::shared_ptr<NodeArena> &other);
+
+private:
+    struct Destructor
+    {
+        void *object;
+        void (*destroy)(void *);
+    };
+
+    template <typename T>
+    static void destroy(void *object)
+    {
+        static_cast<T *>(object)->~T();
+    }
+
+    void *allocate(size_t size, size_t align);
+
+    std::vector<std::unique_ptr<char[]>> _chunks;
+    char *_next = nullptr;
+    char *_end = nullptr;
+    std::vector<Destructor> _destructors;
+    std::vector<std::shared_ptr<NodeArena>> _adopted;
+};
+
+#endif // NODEARENA_H
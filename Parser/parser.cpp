@@ -23,54 +23,356 @@
  ***************************************************************************/
 
 #include <cassert>
+#include <cstring>
+#include <algorithm>
 
-#include "lex_helper.h"
 #include "parser.h"
+#include "syntaxcloner.h"
+
+const int AnnaParser::WorkerMaxDepth;
+
+// Binary operators, one row per token from DEF on. Higher precedence binds
+// tighter; 0 is not a binary operator.
+struct BinaryOperator
+{
+    int precedence;
+    bool leftAssociative;
+};
+
+static constexpr BinaryOperator binary_operators[] = {
+    {0, false},     // def
+    {0, false},     // main
+    {0, false},     // if
+    {0, false},     // else
+    {0, false},     // while
+    {7, true},      // >=
+    {7, true},      // <=
+    {6, true},      // ==
+    {6, true},      // !=
+    {5, true},      // &
+    {3, true},      // |
+    {4, true},      // ^
+    {7, true},      // >
+    {7, true},      // <
+    {8, true},      // +
+    {8, true},      // -
+    {9, true},      // *
+    {9, true},      // /
+    {9, true},      // %
+    {0, false},     // !
+    {0, false},     // ~
+    {2, true},      // &&
+    {1, true},      // ||
+    {0, false},     // =
+    {0, false},     // import
+    {0, false},     // return
+    {0, false},     // var
+    {0, false},     // user function identifier
+    {0, false},     // identifier
+    {0, false},     // variable identifier
+    {0, false},     // string
+    {0, false},     // real
+    {0, false},     // integer
+    {0, false},     // boolean
+    {0, false},     // ;
+    {0, false},     // (
+    {0, false},     // )
+    {0, false},     // {
+    {0, false},     // }
+    {0, false},     // [
+    {0, false},     // ]
+    {0, false},     // ,
+};
+
+static constexpr size_t binary_operator_count = sizeof(binary_operators) / sizeof(binary_operators[0]);
+static_assert(binary_operator_count == COMMA - DEF + 1, "binary_operators needs a row for every token");
+
+static inline BinaryOperator binary_operator(Tokens token)
+{
+    size_t index = token - DEF;
+    return index < binary_operator_count ? binary_operators[index] : BinaryOperator{0, false};
+}
 
 AnnaParser::AnnaParser(FILE *in, const std::string &fileName, const std::string compilationUnitName)
 {
-    lexer_init(in, fileName);
+    _inputFailed = !_lexer.init(in, fileName);
+    _tokens.setSource(_lexer.source());
     _filename = fileName;
-    errorStreams.push(std::make_shared<std::stringstream>());
+    parserMarks.reserve(64);
     _compilationUnitName = std::make_shared<std::string>(compilationUnitName);
 }
 
-AnnaParser::AnnaParser(char *text, size_t len, const std::string &fileName, const std::string compilationUnitName)
+AnnaParser::AnnaParser(const char *text, size_t len, const std::string &fileName, const std::string compilationUnitName)
 {
-    lexer_init(text, len, fileName);
+    _inputFailed = !_lexer.init(text, len, fileName);
+    _tokens.setSource(_lexer.source());
     _filename = fileName;
-    errorStreams.push(std::make_shared<std::stringstream>());
+    parserMarks.reserve(64);
     _compilationUnitName = std::make_shared<std::string>(compilationUnitName);
 }
 
+AnnaParser::AnnaParser(const std::string &path, const std::string compilationUnitName)
+{
+    _inputFailed = !_lexer.init(path);
+    _tokens.setSource(_lexer.source());
+    _filename = path;
+    parserMarks.reserve(64);
+    _compilationUnitName = std::make_shared<std::string>(compilationUnitName);
+}
+
+AnnaParser::AnnaParser(const AnnaParser &unit, TokenBuffer &&tokens, std::shared_ptr<NodeArena> arena)
+    : _tokens(std::move(tokens)), _arena(std::move(arena))
+{
+    _tokens.setArena(_arena.get());
+    _tokens.append(END, 0, 0, 0, 0);
+    _lexDone = true;
+    currentTokenIdx = _tokens.begin();
+    _filename = unit._filename;
+    _memoize = unit._memoize;
+    _maxDepth = std::min(unit._maxDepth, WorkerMaxDepth);
+    parserMarks.reserve(64);
+    _compilationUnitName = unit._compilationUnitName;
+}
+
 AnnaParser::~AnnaParser()
 {
-    lexer_finalize();
+    finishDefinitionJobs();
+    _lexer.finalize();
 }
 
 gcnCompilationUnit AnnaParser::parse()
 {
-    lexall();
+    // The source could not be read; init() has already said why
+    if (_inputFailed)
+        return nullptr;
+
+    // Tokens are pulled from the lexer as the parser reaches them
     return parseCompilationUnit();
 }
 
 bool AnnaParser::lexall()
 {
-    gcnToken token = tokenize();
-    while (token->token() > 0) {
-        tokens.push_back(token);
-        token = tokenize();
-    }
-    tokens.push_back(std::make_shared<AnnaToken>(END, std::make_shared<std::string>("EOF"), 0, 0, 0));
-    currentToken = tokens.front();
+    if (_inputFailed)
+        return false;
 
-    if (token->token() == ERROR) {
+    while (!_lexDone)
+        bufferToken(_tokens.end());
+
+    return !_lexFailed;
+}
+
+void AnnaParser::setMemoization(bool enabled)
+{
+    _memoize = enabled;
+    clearMemo();
+}
+
+void AnnaParser::setParallel(bool enabled)
+{
+    _parallel = enabled;
+}
+
+void AnnaParser::setMaxDepth(int depth)
+{
+    _maxDepth = depth;
+}
+
+bool AnnaParser::tooDeep(const char *caller)
+{
+    if (_depth <= _maxDepth)
         return false;
-    }
 
+    size_t i = significantToken(currentTokenIdx);
+    _diagnostics.push_back(Diagnostic{_tokens.kind(i), _tokens.offset(i), _tokens.length(i),
+                                      _tokens.row(i), _tokens.col(i), "shallower nesting", caller});
+    _depthExceeded = true;
     return true;
 }
 
+void AnnaParser::queueDefinitionJobs(size_t first)
+{
+    // The parser went past the scan, at the top level
+    if (_scanIdx < first) {
+        _scanIdx = first;
+        _scanDef = SIZE_MAX;
+        _scanDepth = 0;
+    }
+
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // A definition runs from a top-level `def' to the brace closing its
+    // body. Tokens from first on stay in the window while the scan is
+    // ahead, since the parser holds a mark at first.
+    while (_definitionJobs.size() < 2 * threads && bufferToken(_scanIdx)) {
+        switch (_tokens.kind(_scanIdx)) {
+            case DEF:
+                if (_scanDepth == 0)
+                    _scanDef = _scanIdx;
+                break;
+            case OPEN_BRACE:
+                ++_scanDepth;
+                break;
+            case CLOSE_BRACE:
+                if (_scanDepth > 0 && --_scanDepth == 0 && _scanDef != SIZE_MAX) {
+                    std::shared_ptr<DefinitionJob> job = std::make_shared<DefinitionJob>();
+                    job->begin = _scanDef;
+                    job->end = _scanIdx + 1;
+                    job->tokens = _tokens.slice(_scanDef, _scanIdx + 1);
+                    job->finished = job->done.get_future();
+                    _definitionJobs.push_back(job);
+                    _scanDef = SIZE_MAX;
+
+                    {
+                        std::lock_guard<std::mutex> lock(_definitionMutex);
+                        _unstartedDefinitionJobs.push_back(job);
+                    }
+                    _definitionQueued.notify_one();
+                    if (_definitionWorkers.size() < threads)
+                        _definitionWorkers.emplace_back(&AnnaParser::runDefinitionJobs, this);
+                }
+                break;
+            default:
+                break;
+        }
+        ++_scanIdx;
+    }
+}
+
+void AnnaParser::runDefinitionJobs()
+{
+    std::shared_ptr<NodeArena> arena = std::make_shared<NodeArena>();
+    for (;;) {
+        std::shared_ptr<DefinitionJob> job;
+        {
+            std::unique_lock<std::mutex> lock(_definitionMutex);
+            _definitionQueued.wait(lock, [this] {
+                return _closingDefinitionJobs || !_unstartedDefinitionJobs.empty();
+            });
+            if (_closingDefinitionJobs)
+                return;
+            job = std::move(_unstartedDefinitionJobs.front());
+            _unstartedDefinitionJobs.pop_front();
+        }
+
+        AnnaParser worker(*this, std::move(job->tokens), arena);
+        job->arena = arena;
+        job->definition = worker.parseFunctionDefinition();
+        if (worker.currentTokenIdx != job->end)
+            job->definition = nullptr;
+        // Too deep for the worker's stack, but maybe not for the parser's
+        if (worker._depthExceeded && worker._maxDepth < _maxDepth)
+            job->definition = nullptr;
+        job->diagnostics = std::move(worker._diagnostics);
+        job->recovered = std::move(worker._recovered);
+        job->materialized = worker._tokens.materialized(job->begin, job->end);
+        job->done.set_value();
+    }
+}
+
+gcnFunctionDefinition AnnaParser::takeDefinitionJob(std::vector<gcnToken> &tokens)
+{
+    size_t def = significantToken(currentTokenIdx);
+    if (!_definitionJobs.empty() && _definitionJobs.front()->begin < def) {
+        // A serial parse went past these; no worker needs to start them.
+        // Both queues are in source order.
+        std::lock_guard<std::mutex> lock(_definitionMutex);
+        while (!_unstartedDefinitionJobs.empty() && _unstartedDefinitionJobs.front()->begin < def)
+            _unstartedDefinitionJobs.pop_front();
+    }
+    while (!_definitionJobs.empty() && _definitionJobs.front()->begin < def)
+        _definitionJobs.pop_front();
+
+    if (_definitionJobs.empty() || _definitionJobs.front()->begin != def)
+        return gcnFunctionDefinition();
+
+    std::shared_ptr<DefinitionJob> job = std::move(_definitionJobs.front());
+    _definitionJobs.pop_front();
+    job->finished.wait();
+    if (!job->definition)
+        return gcnFunctionDefinition();
+
+    currentTokenIdx = job->end;
+    _arena->adopt(job->arena);
+    _diagnostics.insert(_diagnostics.end(), job->diagnostics.begin(), job->diagnostics.end());
+    _recovered.insert(_recovered.end(), job->recovered.begin(), job->recovered.end());
+    tokens = std::move(job->materialized);
+    return job->definition;
+}
+
+void AnnaParser::finishDefinitionJobs()
+{
+    {
+        std::lock_guard<std::mutex> lock(_definitionMutex);
+        _closingDefinitionJobs = true;
+    }
+    _definitionQueued.notify_all();
+    for (std::thread &worker : _definitionWorkers)
+        worker.join();
+
+    _definitionWorkers.clear();
+    _definitionJobs.clear();
+    _unstartedDefinitionJobs.clear();
+    _closingDefinitionJobs = false;
+    _scanIdx = 0;
+    _scanDef = SIZE_MAX;
+    _scanDepth = 0;
+}
+
+void AnnaParser::clearMemo()
+{
+    _memo.clear();
+    _memoDiagnostics.clear();
+}
+
+void AnnaParser::recallMemo(const MemoEntry &entry)
+{
+    currentTokenIdx = entry.end;
+    _diagnostics.insert(_diagnostics.end(),
+                        _memoDiagnostics.begin() + entry.diagnosticBegin,
+                        _memoDiagnostics.begin() + entry.diagnosticEnd);
+}
+
+void AnnaParser::storeMemo(uint64_t key, void *node, size_t diagnosticCount)
+{
+    // A failed rule leaves its diagnostics behind; keep them for replay
+    MemoEntry entry;
+    entry.node = std::move(node);
+    entry.end = currentTokenIdx;
+    entry.diagnosticBegin = _memoDiagnostics.size();
+    _memoDiagnostics.insert(_memoDiagnostics.end(), _diagnostics.begin() + diagnosticCount, _diagnostics.end());
+    entry.diagnosticEnd = _memoDiagnostics.size();
+    _memo[key] = std::move(entry);
+}
+
+bool AnnaParser::fetchToken(size_t index)
+{
+    bool buffered = bufferToken(index);
+
+    // Past the end the parser sees END
+    _furthestToken = std::max(_furthestToken, buffered ? index : _tokens.end() - 1);
+    return buffered;
+}
+
+bool AnnaParser::bufferToken(size_t index)
+{
+    if (index < _tokens.end())
+        return true;
+
+    // Nothing before the oldest mark can be revisited
+    _tokens.discard(parserMarks.empty() ? currentTokenIdx : parserMarks.front().tokenIdx);
+
+    while (!_lexDone && index >= _tokens.end()) {
+        Tokens kind = _lexer.scan(_tokens);
+        if (kind <= 0) {
+            _tokens.append(END, static_cast<uint32_t>(_lexer.sourceLength()), 0, 0, 0);
+            _lexDone = true;
+            _lexFailed = kind == ERROR;
+        }
+    }
+
+    return index < _tokens.end();
+}
+
 gcnEOS AnnaParser::parseEOS()
 {
     pushParserStatus();
@@ -84,78 +386,343 @@ gcnEOS AnnaParser::parseEOS()
         return gcnEOS();
     }
 
-    while (peekToken(0, true)->token() == T){
+    while (peekToken(0, true) == T){
         tok = eatToken(true);
         eos.push_back(tok);
     }
 
     popParserStatus();
-    return std::make_shared<AnnaEOSSyntax>(eos);
+    return make<AnnaEOSSyntax>(eos);
 }
 
 gcnCompilationUnit AnnaParser::parseCompilationUnit()
 {
-    pushParserStatus();
-    std::vector<gcnImportDirective> imports;
-    std::vector<gcnVariableDeclarationStatement> variableDeclarations;
-    std::vector<gcnFunctionDefinition> functionDefinitions;
+    _arena = std::make_shared<NodeArena>();
+    _tokens.setArena(_arena.get());
+    _declarations.clear();
+    _diagnostics.clear();
+    _recovered.clear();
+    _furthestToken = 0;
+
+    parseDeclarations(nullptr);
+
+    finishDefinitionJobs();
+    return buildCompilationUnit();
+}
 
-    while (peekToken()->token() == IMPORT || peekToken()->token() == VAR || peekToken()->token() == DEF) {
-        if (peekToken()->token() == IMPORT) {
+void AnnaParser::parseDeclarations(Resume *resume)
+{
+    while (peekToken() != END) {
+        size_t first = significantToken(currentTokenIdx);
+        if (resume && resumeDeclarations(first, *resume))
+            return;
+
+        // Nothing parsed before this declaration is revisited. Its mark
+        // keeps the tokens in the window until it has been recorded.
+        clearMemo();
+        pushParserStatus();
+        if (_parallel && !resume)
+            queueDefinitionJobs(first);
+        size_t attempt = _diagnostics.size();
+        size_t recoveredCount = _recovered.size();
+        std::vector<gcnToken> tokens;
+
+        if (peekToken() == IMPORT) {
             gcnImportDirective import = parseImportDirective();
             if (import) {
-                imports.push_back(import);
+                addDeclaration(Declaration::Import, import, first, recoveredCount, std::move(tokens));
                 continue;
             }
         }
 
-        if (peekToken()->token() == VAR) {
+        if (peekToken() == VAR) {
             gcnVariableDeclarationStatement variableDeclaration = parseVariableDeclarationStatement();
             if (variableDeclaration) {
-                variableDeclarations.push_back(variableDeclaration);
+                addDeclaration(Declaration::Variable, variableDeclaration, first, recoveredCount, std::move(tokens));
                 continue;
             }
         }
 
-        if (peekToken()->token() == DEF) {
-            gcnFunctionDefinition functionDefinition = parseFunctionDefinition();
+        if (peekToken() == DEF) {
+            gcnFunctionDefinition functionDefinition = nullptr;
+            if (_parallel)
+                functionDefinition = takeDefinitionJob(tokens);
+            if (!functionDefinition)
+                functionDefinition = parseFunctionDefinition();
             if (functionDefinition) {
-                functionDefinitions.push_back(functionDefinition);
+                addDeclaration(Declaration::Function, functionDefinition, first, recoveredCount, std::move(tokens));
                 continue;
             }
         }
+
+        gcnError error = recover(attempt, "declaration", __func__, true);
+        addDeclaration(Declaration::Error, error, first, recoveredCount, std::move(tokens));
     }
+}
 
-    if (peekToken()->token() == END && (!imports.empty() || !variableDeclarations.empty() || !functionDefinitions.empty())) {
-        popParserStatus();
-        return std::make_shared<AnnaCompilationUnitSyntax>(imports, variableDeclarations, functionDefinitions, _compilationUnitName);
-    } else {
-        // TODO: add error output here: expected declaration ... EOF here but got ...
-        revertParserStatus();
-        return gcnCompilationUnit();
+void AnnaParser::addDeclaration(Declaration::Kind kind, AnnaSyntax *node, size_t first,
+                                size_t recoveredCount, std::vector<gcnToken> &&tokens)
+{
+    size_t last = currentTokenIdx - 1;
+
+    Declaration declaration;
+    declaration.kind = kind;
+    declaration.node = node;
+    declaration.arena = _arena;
+    declaration.begin = _tokens.offset(first);
+    declaration.end = _tokens.offset(last) + _tokens.length(last);
+    declaration.beginRow = _tokens.row(first);
+    declaration.beginCol = _tokens.col(first);
+    declaration.endRow = _tokens.isNewline(last) ? _tokens.row(last) + 1 : _tokens.row(last);
+    declaration.endCol = _tokens.isNewline(last) ? 0 : _tokens.col(last) + _tokens.length(last);
+    bool parsedHere = tokens.empty();
+    declaration.tokens = parsedHere ? _tokens.materialized(first, currentTokenIdx) : std::move(tokens);
+    declaration.recovered.assign(_recovered.begin() + recoveredCount, _recovered.end());
+
+    // A definition from a worker looked no further than the token after
+    // it, which significantToken() records as looked at. END depends on
+    // all of the rest of the source.
+    significantToken(currentTokenIdx);
+    size_t furthest = _furthestToken;
+    if (_tokens.kind(furthest) == END)
+        declaration.lookaheadEnd = SIZE_MAX;
+    else
+        declaration.lookaheadEnd = _tokens.offset(furthest) + _tokens.length(furthest) + LexerContext::MaxLookahead;
+
+    _declarations.push_back(std::move(declaration));
+    popParserStatus();
+}
+
+bool AnnaParser::resumeDeclarations(size_t first, Resume &resume)
+{
+    std::vector<Declaration> &after = resume.declarations;
+    size_t offset = _tokens.offset(first);
+    while (resume.next < after.size() && after[resume.next].begin + resume.delta < offset)
+        ++resume.next;
+
+    if (resume.next == after.size() || after[resume.next].begin + resume.delta != offset)
+        return false;
+
+    // Comments before a declaration belong to its first token. A token
+    // that starts in the same column lexes the same from there on, so
+    // everything after it moves by whole rows.
+    const Declaration &next = after[resume.next];
+    if (next.beginCol != _tokens.col(first) || next.tokens.empty())
+        return false;
+    gcnToken front = next.tokens.front();
+    if (front->row() != next.beginRow || front->col() != next.beginCol
+            || front->trailingComments() != _tokens.trailingComments(first))
+        return false;
+
+    // Declarations on other rows are copied, so that the tree they came
+    // from keeps its rows
+    int lines = _tokens.row(first) - next.beginRow;
+    SyntaxCloner cloner(*_arena, lines);
+    for (size_t i = resume.next; i < after.size(); ++i) {
+        Declaration &declaration = after[i];
+        declaration.begin += resume.delta;
+        declaration.end += resume.delta;
+        if (declaration.lookaheadEnd != SIZE_MAX)
+            declaration.lookaheadEnd += resume.delta;
+        declaration.beginRow += lines;
+        declaration.endRow += lines;
+        if (lines) {
+            declaration.node = cloner.clone(declaration.node);
+            for (gcnToken &token : declaration.tokens)
+                token = cloner.cloneToken(token);
+            declaration.arena = _arena;
+        }
+        // END is always reported at the first row
+        for (Diagnostic &diagnostic : declaration.recovered) {
+            diagnostic.offset += resume.delta;
+            if (diagnostic.found != END)
+                diagnostic.row += lines;
+        }
+
+        _recovered.insert(_recovered.end(), declaration.recovered.begin(), declaration.recovered.end());
+        _declarations.push_back(std::move(declaration));
     }
+    return true;
+}
+
+gcnCompilationUnit AnnaParser::buildCompilationUnit()
+{
+    // Empty input
+    if (_declarations.empty()) {
+        _unit.reset();
+        return _unit;
+    }
+
+    std::vector<gcnImportDirective> imports;
+    std::vector<gcnVariableDeclarationStatement> variableDeclarations;
+    std::vector<gcnFunctionDefinition> functionDefinitions;
+    std::vector<gcnError> errors;
+    std::vector<AnnaSyntax *> declarations;
+
+    for (const Declaration &declaration : _declarations) {
+        // Declarations kept by reparse() live in the arena of an earlier tree
+        _arena->adopt(declaration.arena);
+        declarations.push_back(declaration.node);
+        switch (declaration.kind) {
+            case Declaration::Import:
+                imports.push_back(static_cast<AnnaImportDirectiveSyntax *>(declaration.node));
+                break;
+            case Declaration::Variable:
+                variableDeclarations.push_back(static_cast<AnnaVariableDeclarationStatementSyntax *>(declaration.node));
+                break;
+            case Declaration::Function:
+                functionDefinitions.push_back(static_cast<AnnaFunctionDefinitionSyntax *>(declaration.node));
+                break;
+            case Declaration::Error:
+                errors.push_back(static_cast<AnnaErrorSyntax *>(declaration.node));
+                break;
+        }
+    }
+
+    _diagnostics = _recovered;
+    _recovered.clear();
+    AnnaCompilationUnitSyntax *unit = make<AnnaCompilationUnitSyntax>(imports, variableDeclarations, functionDefinitions,
+                                                                      _compilationUnitName, errors, declarations);
+    _unit = gcnCompilationUnit(_arena, unit);
+    return _unit;
+}
+
+gcnCompilationUnit AnnaParser::reparse(gcnCompilationUnit previous, size_t offset, size_t removed, const std::string &inserted)
+{
+    // A stale offset from the caller; nothing is changed
+    size_t length = _lexer.sourceLength();
+    if (offset > length) {
+        fprintf(__log_out, "Cannot edit %s at offset %zu, past its end at %zu\n", _filename.c_str(), offset, length);
+        _editFailed = true;
+        return nullptr;
+    }
+    _editFailed = false;
+    removed = std::min(removed, length - offset);
+
+    size_t editEnd = offset + removed;
+    if (previous != _unit)
+        _declarations.clear();
+
+    // A declaration is kept if the edit starts clear of all the text
+    // lexing the tokens it looked at may have read
+    size_t kept = 0;
+    while (kept < _declarations.size() && _declarations[kept].lookaheadEnd <= offset)
+        ++kept;
+
+    // Declarations wholly after the edit may be picked up again
+    Resume resume;
+    resume.next = 0;
+    resume.delta = static_cast<ptrdiff_t>(inserted.size()) - static_cast<ptrdiff_t>(removed);
+    for (size_t i = kept; i < _declarations.size(); ++i) {
+        if (_declarations[i].begin >= editEnd)
+            resume.declarations.push_back(std::move(_declarations[i]));
+    }
+    _declarations.resize(kept);
+
+    _lexer.edit(offset, removed, inserted);
+    if (kept)
+        _lexer.restart(_declarations.back().end, _declarations.back().endRow, _declarations.back().endCol);
+    else
+        _lexer.restart(0, 0, 0);
+    _tokens.clear();
+    _tokens.setSource(_lexer.source());
+    _arena = std::make_shared<NodeArena>();
+    _tokens.setArena(_arena.get());
+    _lexDone = false;
+    _lexFailed = false;
+    currentTokenIdx = 0;
+    _furthestToken = 0;
+    parserMarks.clear();
+    clearMemo();
+
+    _diagnostics.clear();
+    _recovered.clear();
+    for (const Declaration &declaration : _declarations)
+        _recovered.insert(_recovered.end(), declaration.recovered.begin(), declaration.recovered.end());
+
+    parseDeclarations(&resume);
+    return buildCompilationUnit();
+}
+
+gcnError AnnaParser::recover(size_t diagnosticCount, const char *expected, const char *caller, bool topLevel)
+{
+    currentTokenIdx = significantToken(currentTokenIdx);
+
+    // Mismatches short of the furthest one come from alternatives that
+    // were ruled out. END has no offset of its own but is furthest of all.
+    auto reach = [](const Diagnostic &diagnostic) {
+        return diagnostic.found == END ? UINT32_MAX : diagnostic.offset;
+    };
+
+    if (diagnosticCount == _diagnostics.size()) {
+        size_t i = currentTokenIdx;
+        _diagnostics.push_back(Diagnostic{_tokens.kind(i), _tokens.offset(i), _tokens.length(i),
+                                          _tokens.row(i), _tokens.col(i), expected, caller});
+    }
+
+    uint32_t furthest = 0;
+    for (size_t i = diagnosticCount; i < _diagnostics.size(); ++i)
+        furthest = std::max(furthest, reach(_diagnostics[i]));
+
+    size_t recoveredCount = _recovered.size();
+    for (size_t i = diagnosticCount; i < _diagnostics.size(); ++i) {
+        const Diagnostic &diagnostic = _diagnostics[i];
+        if (reach(diagnostic) != furthest)
+            continue;
+
+        auto same = [&diagnostic](const Diagnostic &other) {
+            return other.expected == diagnostic.expected && other.caller == diagnostic.caller;
+        };
+        if (std::none_of(_recovered.begin() + recoveredCount, _recovered.end(), same))
+            _recovered.push_back(diagnostic);
+    }
+    _diagnostics.resize(diagnosticCount);
+
+    // At least one token is skipped, so the caller always makes progress
+    std::vector<gcnToken> skipped;
+    int depth = 0;
+    for (Tokens kind = peekToken(0, true); kind != END; kind = peekToken(0, true)) {
+        if (!skipped.empty()) {
+            // `def' and `import' never occur inside a function
+            if (kind == DEF || kind == IMPORT)
+                break;
+            if (depth == 0 && (kind == VAR || (kind == CLOSE_BRACE && !topLevel)))
+                break;
+        }
+
+        skipped.push_back(eatToken(true));
+
+        if (kind == OPEN_BRACE)
+            ++depth;
+        else if (kind == CLOSE_BRACE && depth > 0)
+            --depth;
+        else if (kind == T && depth == 0)
+            break;
+    }
+
+    return make<AnnaErrorSyntax>(skipped);
 }
 
 gcnImportDirective AnnaParser::parseImportDirective()
 {
-    assert(peekToken()->token() == IMPORT);
+    assert(peekToken() == IMPORT);
 
     pushParserStatus();
-    gcnToken import;
-    gcnIdentifierToken identifier;
-    gcnEOS eos;
+    gcnToken import = nullptr;
+    gcnIdentifierToken identifier = nullptr;
+    gcnEOS eos = nullptr;
 
     import = eatToken(IMPORT, "`import'", __func__);
     if (!import) goto not_import_directive;
 
-    identifier = std::static_pointer_cast<IdentifierToken>(eatToken(IDENTIFIER, "identifier", __func__));
+    identifier = static_cast<IdentifierToken *>(eatToken(IDENTIFIER, "identifier", __func__));
     if (!identifier) goto not_import_directive;
 
     eos = parseEOS();
     if (!eos) goto not_import_directive;
 
     popParserStatus();
-    return std::make_shared<AnnaImportDirectiveSyntax>(import, identifier, eos);
+    return make<AnnaImportDirectiveSyntax>(import, identifier, eos);
 
 not_import_directive:
     revertParserStatus();
@@ -166,12 +733,12 @@ gcnFunctionIdentifier AnnaParser::parseFunctionIdentifier()
 {
     pushParserStatus();
 
-    switch (peekToken(0)->token()) {
+    switch (peekToken(0)) {
         case USER_FUNCTION_IDENTIFIER:
         case IDENTIFIER:
             popParserStatus();
-            return std::make_shared<AnnaFunctionIdentifierSyntax>
-                    (std::static_pointer_cast<IdentifierToken>(eatToken()));
+            return make<AnnaFunctionIdentifierSyntax>
+                    (static_cast<IdentifierToken *>(eatToken()));
         default:
             revertParserStatus();
             return gcnFunctionIdentifier();
@@ -180,14 +747,26 @@ gcnFunctionIdentifier AnnaParser::parseFunctionIdentifier()
 
 gcnExpression AnnaParser::parseExpression()
 {
-    pushParserStatus();
-    gcnExpression expr;
+    Nesting nesting(*this);
+    if (tooDeep(__func__))
+        return gcnExpression();
 
-    expr = parseBinaryOperationExpression();
-    if (expr) { popParserStatus(); return expr; }
+    return memoized(MemoExpression, &AnnaParser::parseExpressionImpl);
+}
 
+gcnExpression AnnaParser::parseExpressionImpl()
+{
+    pushParserStatus();
+    gcnExpression expr = nullptr;
+
+    // A binary operation starts with a unary expression, so that is
+    // parsed once and the operators after it are taken if there are any
     expr = parseUnaryExpression();
-    if (expr) { popParserStatus(); return expr; }
+    if (expr) {
+        gcnBinaryOperationExpression binary = parseBinaryOperationExpression(expr);
+        popParserStatus();
+        return binary ? binary : expr;
+    }
 
     expr = parseAssignment();
     if (expr) { popParserStatus(); return expr; }
@@ -196,59 +775,57 @@ gcnExpression AnnaParser::parseExpression()
     return gcnExpression();
 }
 
-gcnBinaryOperationExpression AnnaParser::parseBinaryOperationExpression(int min_precedence)
+gcnBinaryOperationExpression AnnaParser::parseBinaryOperationExpression(gcnExpression left)
 {
     pushParserStatus();
 
-    gcnBinaryOperationExpression result;
+    gcnExpression expr = nullptr;
 
-    gcnExpression left;
-    gcnBinaryOperator op;
-    gcnExpression right;
+    // Without an operator it is a unary expression
+    if (!binary_operator(peekToken()).precedence) goto not_binary_op_expr;
 
-    left = parseUnaryExpression();
-    if (!left) goto not_binary_op_expr;
+    expr = parseBinaryOperands(left, 1);
+    if (!expr) goto not_binary_op_expr;
 
-    while (true) {
-        pushParserStatus();
-        op = parseBinaryOperator();
-        if (!op) {
-            revertParserStatus();
-            break;
-        }
+    popParserStatus();
+    return static_cast<AnnaBinaryOperationExpressionSyntax *>(expr);
 
-        int prec = getPrecedence(op->binOp->token());
-        bool leftAssoc = isLeftAssociative(op->binOp->token());
-        int next_min_prec = leftAssoc ? prec + 1 : prec;
+not_binary_op_expr:
+    revertParserStatus();
+    return gcnBinaryOperationExpression();
+}
 
-        if (prec < min_precedence) {
-            revertParserStatus();
-            break;
-        }
-        popParserStatus();
+gcnExpression AnnaParser::parseBinaryOperands(gcnExpression left, int min_precedence)
+{
+    // Precedence climbing. Each operator is picked by one token of
+    // lookahead, so nothing is parsed twice.
+    while (true) {
+        BinaryOperator info = binary_operator(peekToken());
+        if (info.precedence < min_precedence)
+            return left;
 
-        right = parseBinaryOperationExpression(next_min_prec);
+        gcnBinaryOperator op = make<AnnaBinaryOperatorSyntax>(eatToken());
+
+        gcnExpression right = parseUnaryExpression();
+        if (!right)
+            return gcnExpression();
+        right = parseBinaryOperands(right, info.leftAssociative ? info.precedence + 1 : info.precedence);
         if (!right)
-            right = parseUnaryExpression();
-        if (!right) goto not_binary_op_expr;
+            return gcnExpression();
 
-        result = std::make_shared<AnnaBinaryOperationExpressionSyntax>(result ? result : left, op, right);
+        left = make<AnnaBinaryOperationExpressionSyntax>(left, op, right);
     }
-    if (result) {
-        popParserStatus();
-        return result;
-    } else
-        goto not_binary_op_expr;
-
-not_binary_op_expr:
-    revertParserStatus();
-    return gcnBinaryOperationExpression();
 }
 
 gcnUnaryExpression AnnaParser::parseUnaryExpression()
+{
+    return memoized(MemoUnaryExpression, &AnnaParser::parseUnaryExpressionImpl);
+}
+
+gcnUnaryExpression AnnaParser::parseUnaryExpressionImpl()
 {
     pushParserStatus();
-    gcnUnaryExpression expr;
+    gcnUnaryExpression expr = nullptr;
 
     if (isPossiblePrimaryExpression()) {
         expr = parsePrimaryExpression();
@@ -261,7 +838,7 @@ gcnUnaryExpression AnnaParser::parseUnaryExpression()
 
 bool AnnaParser::isPossiblePrimaryExpression()
 {
-    switch(peekToken()->token()){
+    switch(peekToken()){
         case STRING:
         case REAL:
         case INTEGER:
@@ -279,18 +856,30 @@ bool AnnaParser::isPossiblePrimaryExpression()
 gcnPrimaryExpression AnnaParser::parsePrimaryExpression()
 {
     pushParserStatus();
-    gcnPrimaryExpression expr;
-
-    expr = parseLiteral();
-    if (expr) { popParserStatus(); return expr; }
-
-    expr = parseParenthesizedExpression();
-    if (expr) { popParserStatus(); return expr; }
+    gcnPrimaryExpression expr = nullptr;
 
-    expr = parseInvocationExpression();
-    if (expr) { popParserStatus(); return expr; }
-
-    expr = parseSimpleName();
+    // Invocations start with a function identifier and simple names with
+    // a variable identifier, so every alternative is picked by one token.
+    switch (peekToken()) {
+        case STRING:
+        case REAL:
+        case INTEGER:
+        case BOOLEAN:
+            expr = parseLiteral();
+            break;
+        case OPEN_PAREN:
+            expr = parseParenthesizedExpression();
+            break;
+        case USER_FUNCTION_IDENTIFIER:
+        case IDENTIFIER:
+            expr = parseInvocationExpression();
+            break;
+        case VARIABLE_IDENTIFIER:
+            expr = parseSimpleName();
+            break;
+        default:
+            break;
+    }
     if (expr) { popParserStatus(); return expr; }
 
     revertParserStatus();
@@ -300,7 +889,7 @@ gcnPrimaryExpression AnnaParser::parsePrimaryExpression()
 gcnSimpleName AnnaParser::parseSimpleName()
 {
     pushParserStatus();
-    gcnToken sn;
+    gcnToken sn = nullptr;
     sn = eatToken(VARIABLE_IDENTIFIER, "variable identifier /an+a/", __func__);
     if (!sn) {
         revertParserStatus();
@@ -308,20 +897,20 @@ gcnSimpleName AnnaParser::parseSimpleName()
     }
 
     popParserStatus();
-    return std::make_shared<AnnaSimpleNameSyntax>(sn);
+    return make<AnnaSimpleNameSyntax>(sn);
 }
 
 gcnLiteral AnnaParser::parseLiteral()
 {
     pushParserStatus();
-    switch (peekToken(0)->token()) {
+    switch (peekToken(0)) {
         case STRING:
         case REAL:
         case INTEGER:
         case BOOLEAN:
             popParserStatus();
-            return std::make_shared<AnnaLiteralSyntax>
-                    (std::static_pointer_cast<LiteralToken>(eatToken()));
+            return make<AnnaLiteralSyntax>
+                    (static_cast<LiteralToken *>(eatToken()));
         default:
             revertParserStatus();
             return gcnLiteral();
@@ -331,9 +920,9 @@ gcnLiteral AnnaParser::parseLiteral()
 gcnParenthesizedExpression AnnaParser::parseParenthesizedExpression()
 {
     pushParserStatus();
-    gcnToken lPa;
-    gcnExpression expr;
-    gcnToken rPa;
+    gcnToken lPa = nullptr;
+    gcnExpression expr = nullptr;
+    gcnToken rPa = nullptr;
 
     lPa = eatToken(OPEN_PAREN, "`('", __func__);
     if (!lPa) goto not_parenthesized_expr;
@@ -345,54 +934,22 @@ gcnParenthesizedExpression AnnaParser::parseParenthesizedExpression()
     if (!rPa) goto not_parenthesized_expr;
 
     popParserStatus();
-    return std::make_shared<AnnaParenthesizedExpressionSyntax>(lPa, expr, rPa);
+    return make<AnnaParenthesizedExpressionSyntax>(lPa, expr, rPa);
 
 not_parenthesized_expr:
     revertParserStatus();
     return gcnParenthesizedExpression();
 }
 
-gcnBinaryOperator AnnaParser::parseBinaryOperator()
-{
-    pushParserStatus();
-    switch (peekToken(0)->token()) {
-        case GE:
-        case LE:
-        case NE:
-        case EE:
-        case GT:
-        case LT:
-
-        case ANDAND:
-        case OROR:
-
-        case AND:
-        case OR:
-        case XOR:
-
-        case ADD:
-        case SUB:
-        case MUL:
-        case DIV:
-        case MOD:
-
-            popParserStatus();
-            return std::make_shared<AnnaBinaryOperatorSyntax>(eatToken());
-        default:
-            revertParserStatus();
-            return gcnBinaryOperator();
-    }
-}
-
 gcnInvocationExpression AnnaParser::parseInvocationExpression()
 {
     pushParserStatus();
 
-    gcnFunctionIdentifier id;
-    gcnArgumentList list;
+    gcnFunctionIdentifier id = nullptr;
+    gcnArgumentList list = nullptr;
 
-    gcnToken optOpenP;
-    gcnToken optCloseP;
+    gcnToken optOpenP = nullptr;
+    gcnToken optCloseP = nullptr;
 
     id = parseFunctionIdentifier();
     if (!id) {
@@ -400,7 +957,7 @@ gcnInvocationExpression AnnaParser::parseInvocationExpression()
         return gcnInvocationExpression();
     }
 
-    if (peekToken(0)->token() == OPEN_PAREN) {
+    if (peekToken(0) == OPEN_PAREN) {
         optOpenP = eatToken();
         list = parseArgumentList();
         optCloseP = eatToken(CLOSE_PAREN, "`)'", __func__);
@@ -411,18 +968,18 @@ gcnInvocationExpression AnnaParser::parseInvocationExpression()
 
         popParserStatus();
         if (list)
-            return std::make_shared<AnnaInvocationExpressionSyntax>(id, optOpenP, list, optCloseP);
+            return make<AnnaInvocationExpressionSyntax>(id, optOpenP, list, optCloseP);
         else
-            return std::make_shared<AnnaInvocationExpressionSyntax>(id, optOpenP, optCloseP);
+            return make<AnnaInvocationExpressionSyntax>(id, optOpenP, optCloseP);
 
     } else {
         list = parseArgumentList();
 
         popParserStatus();
         if (list)
-            return std::make_shared<AnnaInvocationExpressionSyntax>(id, list);
+            return make<AnnaInvocationExpressionSyntax>(id, list);
         else
-            return std::make_shared<AnnaInvocationExpressionSyntax>(id);
+            return make<AnnaInvocationExpressionSyntax>(id);
     }
 }
 
@@ -431,7 +988,7 @@ gcnArgumentList AnnaParser::parseArgumentList()
     pushParserStatus();
     AnnaSeperatedList<gcnExpression> list;
 
-    gcnExpression expr;
+    gcnExpression expr = nullptr;
 
     expr = parseExpression();
     if (!expr) {
@@ -440,7 +997,7 @@ gcnArgumentList AnnaParser::parseArgumentList()
     } else
         list.add(expr);
 
-    while (peekToken(0)->token() == COMMA) {
+    while (peekToken(0) == COMMA) {
         list.addSeperator(eatToken());
         expr = parseExpression();
         if (!expr) {
@@ -451,23 +1008,23 @@ gcnArgumentList AnnaParser::parseArgumentList()
     }
 
     popParserStatus();
-    return std::make_shared<AnnaArgumentListSyntax>(list);
+    return make<AnnaArgumentListSyntax>(list);
 }
 
 gcnFunctionDefinition AnnaParser::parseFunctionDefinition()
 {
-    assert(peekToken()->token() == DEF);
+    assert(peekToken() == DEF);
 
     pushParserStatus();
-    gcnFunctionHeader header;
-    gcnFunctionBody body;
+    gcnFunctionHeader header = nullptr;
+    gcnFunctionBody body = nullptr;
     header = parseFunctionHeader();
     if (!header) goto not_function_definition;
     body = parseFunctionBody();
     if (!body) goto not_function_definition;
 
     popParserStatus();
-    return std::make_shared<AnnaFunctionDefinitionSyntax>(header, body);
+    return make<AnnaFunctionDefinitionSyntax>(header, body);
 
 not_function_definition:
     revertParserStatus();
@@ -476,26 +1033,26 @@ not_function_definition:
 
 gcnFunctionHeader AnnaParser::parseFunctionHeader()
 {
-    assert(peekToken()->token() == DEF);
+    assert(peekToken() == DEF);
 
     pushParserStatus();
-    gcnToken def;
-    gcnIdentifierToken id;
-    gcnToken openPar;
-    gcnFormalParameterList parameters;
-    gcnToken closePar;
+    gcnToken def = nullptr;
+    gcnIdentifierToken id = nullptr;
+    gcnToken openPar = nullptr;
+    gcnFormalParameterList parameters = nullptr;
+    gcnToken closePar = nullptr;
     bool hasParam;
     def = eatToken(DEF, "`def'", __func__);
     if (!def) goto not_function_header;
 
-    id = std::static_pointer_cast<IdentifierToken>
+    id = static_cast<IdentifierToken *>
             (eatToken(USER_FUNCTION_IDENTIFIER, "user function identifier starts with @"));
     if (!id) goto not_function_header;
 
     openPar = eatToken(OPEN_PAREN, "`('", __func__);
     if (!openPar) goto not_function_header;
 
-    if (peekToken(0)->token() == CLOSE_PAREN) {
+    if (peekToken(0) == CLOSE_PAREN) {
         hasParam = false;
         closePar = eatToken(CLOSE_PAREN, "`)'", __func__);
         if (!closePar) goto not_function_header;
@@ -510,9 +1067,9 @@ gcnFunctionHeader AnnaParser::parseFunctionHeader()
 
     popParserStatus();
     if (hasParam)
-        return std::make_shared<AnnaFunctionHeaderSyntax>(def, id, openPar, parameters, closePar);
+        return make<AnnaFunctionHeaderSyntax>(def, id, openPar, parameters, closePar);
     else
-        return std::make_shared<AnnaFunctionHeaderSyntax>(def, id, openPar, closePar);
+        return make<AnnaFunctionHeaderSyntax>(def, id, openPar, closePar);
 
 not_function_header:
     revertParserStatus();
@@ -523,7 +1080,7 @@ gcnFormalParameterList AnnaParser::parseFormalParameterList()
 {
     pushParserStatus();
     AnnaSeperatedList<gcnFormalParameter> list;
-    gcnFormalParameter param;
+    gcnFormalParameter param = nullptr;
 
     param = parseFormalParameter();
     if (!param)
@@ -531,7 +1088,7 @@ gcnFormalParameterList AnnaParser::parseFormalParameterList()
     else
         list.add(param);
 
-    while (peekToken(0)->token() == COMMA) {
+    while (peekToken(0) == COMMA) {
         gcnToken comma = eatToken(COMMA, "`,'", __func__);
         assert(comma);
         param = parseFormalParameter();
@@ -541,7 +1098,7 @@ gcnFormalParameterList AnnaParser::parseFormalParameterList()
         list.add(param);
     }
     popParserStatus();
-    return std::make_shared<AnnaFormalParameterListSyntax>(list);
+    return make<AnnaFormalParameterListSyntax>(list);
 
 not_formal_param_list:
     revertParserStatus();
@@ -551,14 +1108,14 @@ not_formal_param_list:
 gcnFormalParameter AnnaParser::parseFormalParameter()
 {
     pushParserStatus();
-    gcnIdentifierToken param;
-    param = std::static_pointer_cast<IdentifierToken>(eatToken(VARIABLE_IDENTIFIER, "variable identifier /an+a/", __func__));
+    gcnIdentifierToken param = nullptr;
+    param = static_cast<IdentifierToken *>(eatToken(VARIABLE_IDENTIFIER, "variable identifier /an+a/", __func__));
     if (!param) {
         revertParserStatus();
         return gcnFormalParameter();
     } else {
         popParserStatus();
-        return std::make_shared<AnnaFormalParameterSyntax>(param);
+        return make<AnnaFormalParameterSyntax>(param);
     }
 }
 
@@ -572,25 +1129,31 @@ gcnFunctionBody AnnaParser::parseFunctionBody()
     }
 
     popParserStatus();
-    return std::make_shared<AnnaFunctionBodySyntax>(block);
+    return make<AnnaFunctionBodySyntax>(block);
 }
 
 gcnBlock AnnaParser::parseBlock()
 {
     pushParserStatus();
-    gcnToken openBra;
-    gcnToken closeBra;
+    gcnToken openBra = nullptr;
+    gcnToken closeBra = nullptr;
     std::vector<gcnStatement> statements;
-    gcnStatement statement;
+    gcnStatement statement = nullptr;
 
     openBra = eatToken(OPEN_BRACE, "`{'", __func__);
     if (!openBra) goto not_block;
 
-    do {
+    while (peekToken() != CLOSE_BRACE && peekToken() != END) {
+        size_t attempt = _diagnostics.size();
         statement = parseStatement();
-        if (statement)
-            statements.push_back(statement);
-    } while (statement);
+        if (!statement) {
+            // Most likely a missing `}'; let the declaration fail instead
+            if (peekToken() == DEF || peekToken() == IMPORT)
+                break;
+            statement = recover(attempt, "statement", __func__, false);
+        }
+        statements.push_back(statement);
+    }
 
     closeBra = eatToken(CLOSE_BRACE, "`}'", __func__);
     if (!closeBra) goto not_block;
@@ -602,7 +1165,7 @@ gcnBlock AnnaParser::parseBlock()
     }
 
     popParserStatus();
-    return std::make_shared<AnnaBlockSyntax>(openBra, statements, closeBra);
+    return make<AnnaBlockSyntax>(openBra, statements, closeBra);
 
 not_block:
     revertParserStatus();
@@ -612,14 +1175,19 @@ not_block:
 gcnStatement AnnaParser::parseStatement()
 {
     pushParserStatus();
-    gcnStatement stat;
+    gcnStatement stat = nullptr;
 
-    if (peekToken()->token() == VAR) {
+    // VAR only starts a variable declaration; everything else is an
+    // embedded statement, which still takes a raw T after a failed VAR.
+    if (peekToken() == VAR) {
         stat = parseVariableDeclarationStatement();
         if (stat) { popParserStatus(); return stat; }
-    }
 
-    stat = parseEmbeddedStatement();
+        if (peekToken(0, true) == T)
+            stat = parseEmptyStatement();
+    } else {
+        stat = parseEmbeddedStatement();
+    }
     if (stat) { popParserStatus(); return stat; }
 
     revertParserStatus();
@@ -628,26 +1196,43 @@ gcnStatement AnnaParser::parseStatement()
 
 gcnEmbeddedStatement AnnaParser::parseEmbeddedStatement()
 {
-    pushParserStatus();
-    gcnEmbeddedStatement stat;
-
-    stat = parseBlock();
-    if (stat) { popParserStatus(); return stat; }
-
-    stat = parseIterationStatement();
-    if (stat) { popParserStatus(); return stat; }
-
-    stat = parseSelectionStatement();
-    if (stat) { popParserStatus(); return stat; }
-
-    stat = parseExpressionStatement();
-    if (stat) { popParserStatus(); return stat; }
+    Nesting nesting(*this);
+    if (tooDeep(__func__))
+        return gcnEmbeddedStatement();
 
-    stat = parseReturnStatement();
+    pushParserStatus();
+    gcnEmbeddedStatement stat = nullptr;
+
+    // The FIRST sets of the alternatives are disjoint (see anna.ebnf), so
+    // the next significant token picks one. Only an empty statement can
+    // still match when it fails, since it starts at a raw T.
+    switch (peekToken()) {
+        case OPEN_BRACE:
+            stat = parseBlock();
+            break;
+        case WHILE:
+            stat = parseIterationStatement();
+            break;
+        case IF:
+            stat = parseSelectionStatement();
+            break;
+        case USER_FUNCTION_IDENTIFIER:
+        case IDENTIFIER:
+        case VARIABLE_IDENTIFIER:
+            stat = parseExpressionStatement();
+            break;
+        case RETURN:
+            stat = parseReturnStatement();
+            break;
+        default:
+            break;
+    }
     if (stat) { popParserStatus(); return stat; }
 
-    stat = parseEmptyStatement();
-    if (stat) { popParserStatus(); return stat; }
+    if (peekToken(0, true) == T) {
+        stat = parseEmptyStatement();
+        if (stat) { popParserStatus(); return stat; }
+    }
 
     revertParserStatus();
     return gcnEmbeddedStatement();
@@ -655,23 +1240,23 @@ gcnEmbeddedStatement AnnaParser::parseEmbeddedStatement()
 
 gcnVariableDeclarationStatement AnnaParser::parseVariableDeclarationStatement()
 {
-    assert(peekToken()->token() == VAR);
+    assert(peekToken() == VAR);
 
     pushParserStatus();
-    gcnToken var;
-    gcnIdentifierToken varid;
+    gcnToken var = nullptr;
+    gcnIdentifierToken varid = nullptr;
     bool hasAssign = false;
-    gcnToken eq;
-    gcnPrimaryExpression primaryExpr;
-    gcnEOS eos;
+    gcnToken eq = nullptr;
+    gcnPrimaryExpression primaryExpr = nullptr;
+    gcnEOS eos = nullptr;
 
     var = eatToken(VAR, "`var", __func__);
     if (!var) goto not_var_declaration;
 
-    varid = std::static_pointer_cast<IdentifierToken>(eatToken(VARIABLE_IDENTIFIER));
+    varid = static_cast<IdentifierToken *>(eatToken(VARIABLE_IDENTIFIER));
     if (!varid) goto not_var_declaration;
 
-    if (peekToken(0)->token() == EQ) {
+    if (peekToken(0) == EQ) {
         hasAssign = true;
 
         eq = eatToken(EQ, "`='", __func__);
@@ -690,11 +1275,11 @@ gcnVariableDeclarationStatement AnnaParser::parseVariableDeclarationStatement()
 
     if (hasAssign) {
         popParserStatus();
-        return std::make_shared<AnnaVariableDeclarationStatementSyntax>
+        return make<AnnaVariableDeclarationStatementSyntax>
                 (var, varid, eq, primaryExpr, eos);
     } else {
         popParserStatus();
-        return std::make_shared<AnnaVariableDeclarationStatementSyntax>
+        return make<AnnaVariableDeclarationStatementSyntax>
                 (var, varid, eos);
     }
 
@@ -709,7 +1294,7 @@ gcnEmptyStatement AnnaParser::parseEmptyStatement()
     gcnEOS eos = parseEOS();
     if (eos) {
         popParserStatus();
-        return std::make_shared<AnnaEmptyStatementSyntax>(eos);
+        return make<AnnaEmptyStatementSyntax>(eos);
     } else {
         revertParserStatus();
         return gcnEmptyStatement();
@@ -719,15 +1304,15 @@ gcnEmptyStatement AnnaParser::parseEmptyStatement()
 gcnExpressionStatement AnnaParser::parseExpressionStatement()
 {
     pushParserStatus();
-    gcnStatementExpression statExpr;
-    gcnEOS eos;
+    gcnStatementExpression statExpr = nullptr;
+    gcnEOS eos = nullptr;
     statExpr = parseStatementExpression();
     if (!statExpr) goto not_expr_statement;
     eos = parseEOS();
     if (!eos) goto not_expr_statement;
 
     popParserStatus();
-    return std::make_shared<AnnaExpressionStatementSyntax>(statExpr, eos);
+    return make<AnnaExpressionStatementSyntax>(statExpr, eos);
 
 not_expr_statement:
     revertParserStatus();
@@ -737,13 +1322,28 @@ not_expr_statement:
 gcnStatementExpression AnnaParser::parseStatementExpression()
 {
     pushParserStatus();
-    gcnStatementExpression expr;
+    gcnInvocationExpression invocation = nullptr;
+    gcnAssignment assignment = nullptr;
 
-    expr = parseInvocationExpression();
-    if (expr) { popParserStatus(); return expr; }
-
-    expr = parseAssignment();
-    if (expr) { popParserStatus(); return expr; }
+    switch (peekToken()) {
+        case USER_FUNCTION_IDENTIFIER:
+        case IDENTIFIER:
+            invocation = parseInvocationExpression();
+            if (invocation) {
+                popParserStatus();
+                return make<AnnaStatementExpressionSyntax>(invocation);
+            }
+            break;
+        case VARIABLE_IDENTIFIER:
+            assignment = parseAssignment();
+            if (assignment) {
+                popParserStatus();
+                return make<AnnaStatementExpressionSyntax>(assignment);
+            }
+            break;
+        default:
+            break;
+    }
 
     revertParserStatus();
     return gcnStatementExpression();
@@ -752,10 +1352,10 @@ gcnStatementExpression AnnaParser::parseStatementExpression()
 gcnSelectionStatement AnnaParser::parseSelectionStatement()
 {
     pushParserStatus();
-    gcnSelectionStatement stat;
+    gcnSelectionStatement stat = nullptr;
 
     // isPossibleIf
-    if (peekToken(0)->token() == IF) {
+    if (peekToken(0) == IF) {
         stat = parseIfStatement();
         if (stat) { popParserStatus(); return stat; }
     }
@@ -767,11 +1367,11 @@ gcnSelectionStatement AnnaParser::parseSelectionStatement()
 gcnIfStatement AnnaParser::parseIfStatement()
 {
     pushParserStatus();
-    gcnToken _if;
-    gcnToken openPar;
-    gcnExpression expr;
-    gcnToken closePar;
-    gcnEmbeddedStatement stat;
+    gcnToken _if = nullptr;
+    gcnToken openPar = nullptr;
+    gcnExpression expr = nullptr;
+    gcnToken closePar = nullptr;
+    gcnEmbeddedStatement stat = nullptr;
 
     _if = eatToken(IF, "`if", __func__);
     if (!_if) goto not_if_statement;
@@ -788,9 +1388,9 @@ gcnIfStatement AnnaParser::parseIfStatement()
     stat = parseEmbeddedStatement();
     if (!stat) goto not_if_statement;
 
-    if (peekToken(0)->token() == ELSE) {
-        gcnToken _else;
-        gcnEmbeddedStatement elseStat;
+    if (peekToken(0) == ELSE) {
+        gcnToken _else = nullptr;
+        gcnEmbeddedStatement elseStat = nullptr;
         _else = eatToken(ELSE, "`else'", __func__);
         if (!_else) goto not_if_statement;
 
@@ -798,12 +1398,12 @@ gcnIfStatement AnnaParser::parseIfStatement()
         if (!elseStat) goto not_if_statement;
 
         popParserStatus();
-        return std::make_shared<AnnaIfStatementSyntax>
+        return make<AnnaIfStatementSyntax>
                 (_if, openPar, expr, closePar, stat, _else, elseStat);
     }
 
     popParserStatus();
-    return std::make_shared<AnnaIfStatementSyntax>(_if, openPar, expr, closePar, stat);
+    return make<AnnaIfStatementSyntax>(_if, openPar, expr, closePar, stat);
 
 not_if_statement:
     revertParserStatus();
@@ -813,7 +1413,7 @@ not_if_statement:
 gcnIterationStatement AnnaParser::parseIterationStatement()
 {
     pushParserStatus();
-    gcnIterationStatement stat;
+    gcnIterationStatement stat = nullptr;
 
     // isPossibleWhile
     stat = parseWhileStatement();
@@ -827,11 +1427,11 @@ gcnWhileStatement AnnaParser::parseWhileStatement()
 {
     pushParserStatus();
 
-    gcnToken _while;
-    gcnToken openPar;
-    gcnExpression expr;
-    gcnToken closePar;
-    gcnEmbeddedStatement stats;
+    gcnToken _while = nullptr;
+    gcnToken openPar = nullptr;
+    gcnExpression expr = nullptr;
+    gcnToken closePar = nullptr;
+    gcnEmbeddedStatement stats = nullptr;
 
     _while = eatToken(WHILE, "`while'", __func__);
     if (!_while) goto not_while_statement;
@@ -849,7 +1449,7 @@ gcnWhileStatement AnnaParser::parseWhileStatement()
     if (!stats) goto not_while_statement;
 
     popParserStatus();
-    return std::make_shared<AnnaWhileStatementSyntax>(_while, openPar, expr, closePar, stats);
+    return make<AnnaWhileStatementSyntax>(_while, openPar, expr, closePar, stats);
 
 not_while_statement:
     revertParserStatus();
@@ -857,24 +1457,30 @@ not_while_statement:
 }
 
 gcnAssignment AnnaParser::parseAssignment()
+{
+    return memoized(MemoAssignment, &AnnaParser::parseAssignmentImpl);
+}
+
+gcnAssignment AnnaParser::parseAssignmentImpl()
 {
     pushParserStatus();
 
-    gcnSimpleName left;
-    gcnToken eq;
-    gcnExpression right;
+    gcnSimpleName left = nullptr;
+    gcnToken eq = nullptr;
+    gcnExpression right = nullptr;
 
     left = parseSimpleName();
     if (!left) goto not_assignment;
 
-    eq = eatToken(EQ, "``=''", __func__);
+    // Diagnostics name the rule, not its body
+    eq = eatToken(EQ, "``=''", "parseAssignment");
     if (!eq) goto not_assignment;
 
     right = parseExpression();
     if (!right) goto not_assignment;
 
     popParserStatus();
-    return std::make_shared<AnnaAssignmentSyntax>(left, eq, right);
+    return make<AnnaAssignmentSyntax>(left, eq, right);
 
 not_assignment:
     revertParserStatus();
@@ -884,25 +1490,27 @@ not_assignment:
 gcnReturnStatement AnnaParser::parseReturnStatement()
 {
     pushParserStatus();
-    gcnToken ret;
-    gcnExpression expr;
-    gcnEOS eos;
+    gcnToken ret = nullptr;
+    gcnExpression expr = nullptr;
+    gcnEOS eos = nullptr;
 
     ret = eatToken(RETURN, "`return'", __func__);
     if (!ret) goto not_return_statement;
 
-    if (peekToken(0, true)->token() == T) {
+    if (peekToken(0, true) == T) {
         eos = parseEOS();
         if (!eos) goto not_return_statement;
 
-        return std::make_shared<AnnaReturnStatementSyntax>(ret, eos);
+        popParserStatus();
+        return make<AnnaReturnStatementSyntax>(ret, eos);
     } else {
         expr = parseExpression();
         if (!expr) goto not_return_statement;
         eos = parseEOS();
         if (!eos) goto not_return_statement;
 
-        return std::make_shared<AnnaReturnStatementSyntax>(ret, expr, eos);
+        popParserStatus();
+        return make<AnnaReturnStatementSyntax>(ret, expr, eos);
     }
 
 not_return_statement:
@@ -910,158 +1518,94 @@ not_return_statement:
     return gcnReturnStatement();
 }
 
-int AnnaParser::getPrecedence(Tokens op)
+size_t AnnaParser::significantToken(size_t index)
 {
-    switch (op) {
-        case OROR:
-            return 1;
-
-        case ANDAND:
-            return 2;
-
-        case OR:
-            return 3;
-
-        case XOR:
-            return 4;
-
-        case AND:
-            return 5;
-
-        case EE:
-        case NE:
-            return 6;
-
-        case GE:
-        case LE:
-        case GT:
-        case LT:
-            return 7;
+    fetchToken(index);
+
+    // END is never a newline, so an open run is closed by the end of input
+    size_t next = _tokens.significant(index);
+    while (next == _tokens.end() && fetchToken(next))
+        next = _tokens.significant(index);
+    _furthestToken = std::max(_furthestToken, next);
+    return next;
+}
 
-        case ADD:
-        case SUB:
-            return 8;
+size_t AnnaParser::advanceToken(bool dontIgnoreNewlineT)
+{
+    size_t i = currentTokenIdx;
+    fetchToken(i);
 
-        case MUL:
-        case DIV:
-        case MOD:
-            return 9;
+    if (!dontIgnoreNewlineT)
+        i = significantToken(i);
 
-        default:
-            throw;
-    }
-}
-
-bool AnnaParser::isLeftAssociative(Tokens op)
-{
-    switch (op) {
-        case OROR:
-        case ANDAND:
-        case OR:
-        case XOR:
-        case AND:
-        case EE:
-        case NE:
-        case GE:
-        case LE:
-        case GT:
-        case LT:
-        case ADD:
-        case SUB:
-        case MUL:
-        case DIV:
-        case MOD:
-            return true;
-        default:
-            throw;
-    }
+    // END is never consumed
+    currentTokenIdx = _tokens.kind(i) == END ? i : i + 1;
+    return i;
 }
 
-
 gcnToken AnnaParser::eatToken(bool dontIgnoreNewlineT)
 {
-    if (!dontIgnoreNewlineT) {
-        for (size_t i = currentTokenIdx; i < tokens.size(); ++i) {
-            if (!isNewlineT(tokens[i])) {
-                currentTokenIdx = i + 1;
-                currentToken = tokens[currentTokenIdx];
-                return tokens[i];
-            }
-        }
-        // Out of bound
-        currentToken = tokens[tokens.size() - 1];
-        currentTokenIdx = tokens.size() - 1;
-        return gcnToken();
-    } else {
-        if (++currentTokenIdx < tokens.size()) {
-            gcnToken tok = currentToken;
-            currentToken = tokens[currentTokenIdx];
-            return tok;
-        } else {
-            currentTokenIdx = tokens.size() - 1;
-            currentToken = tokens[currentTokenIdx];
-            return currentToken;
-        }
-    }
+    return _tokens.token(advanceToken(dontIgnoreNewlineT));
 }
 
 gcnToken AnnaParser::eatToken(Tokens kind, const char *expected, const char *caller, bool dontIgnoreNewlineT)
 {
-    pushParserStatus();
-
-    gcnToken tok = eatToken(dontIgnoreNewlineT);
+    size_t mark = currentTokenIdx;
+    size_t i = advanceToken(dontIgnoreNewlineT);
 
-    int row = tok->row();
-    int col = tok->col();
-    int width = tok->width();
-    if (tok->token() != kind) {
-        revertParserStatus();
+    if (_tokens.kind(i) != kind) {
+        revertToken(mark);
 
-        log_print_pos(row, col, _filename, currentErrorStream());
-        if (expected) {
-            currentErrorStream() << "Invalid token `" << tok->text()->c_str()
-                                 << "', expected " << expected << " in " << caller << "\n";
-        } else {
-            currentErrorStream() << "Invalid token `" << tok->text()->c_str() << "'\n";
-        }
-        log_print_row(row, currentErrorStream());
-        log_print_indicators(col, width, currentErrorStream());
+        _diagnostics.push_back(Diagnostic{_tokens.kind(i), _tokens.offset(i), _tokens.length(i),
+                                          _tokens.row(i), _tokens.col(i), expected, caller});
         return gcnToken();
     }
 
-    popParserStatus();
-    return tok;
+    return _tokens.token(i);
 }
 
-gcnToken AnnaParser::peekToken(int ahead, bool dontIgnoreNewlineT)
+void AnnaParser::printErrors()
 {
-    for (unsigned int i = ahead + currentTokenIdx; i < tokens.size(); ++i) {
-        if (dontIgnoreNewlineT)
-            return tokens.at(i);
+    std::stringstream logstream;
+    for (const Diagnostic &diagnostic : _diagnostics)
+        printDiagnostic(diagnostic, logstream);
+    _diagnostics.clear();
 
-        if (!isNewlineT(tokens[i]))
-            return tokens[i];
-    }
-    return gcnToken();
+    std::cout << logstream.str();
 }
 
-void AnnaParser::revertToken(unsigned int index)
+void AnnaParser::printDiagnostic(const Diagnostic &diagnostic, std::stringstream &logstream)
 {
-    assert(index < tokens.size());
+    log_print_pos(diagnostic.row, diagnostic.col, _filename, logstream);
 
-    if (index < tokens.size()) {
-        currentToken = tokens[index];
-        currentTokenIdx = index;
-    }
-}
+    logstream << "Invalid token `";
+    if (diagnostic.found == END)
+        logstream << AnnaToken::spelling(END);
+    else
+        logstream.write(_lexer.source() + diagnostic.offset, diagnostic.length);
 
-bool AnnaParser::isNewlineT(const gcnToken &token)
-{
-    if (token->token() == T && !(token->text()->compare("\n")))
-        return true;
+    if (diagnostic.expected)
+        logstream << "', expected " << diagnostic.expected << " in " << diagnostic.caller << "\n";
     else
-        return false;
+        logstream << "'\n";
+
+    _lexer.printRow(diagnostic.row, logstream);
+    log_print_indicators(diagnostic.col, diagnostic.length, logstream);
 }
 
+Tokens AnnaParser::peekToken(int ahead, bool dontIgnoreNewlineT)
+{
+    size_t i = ahead + currentTokenIdx;
+    if (!fetchToken(i))
+        return END;
 
+    return _tokens.kind(dontIgnoreNewlineT ? i : significantToken(i));
+}
 
+void AnnaParser::revertToken(size_t index)
+{
+    assert(index >= _tokens.begin() && index < _tokens.end());
+
+    if (index >= _tokens.begin() && index < _tokens.end())
+        currentTokenIdx = index;
+}
@@ -29,32 +29,69 @@
 #include "parser_global.h"
 #include "annatoken.h"
 #include "annasyntax.h"
+#include "lex_helper.h"
+#include "nodearena.h"
 
-#include <stack>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
 
 class AnnaParser
 {
 public:
     AnnaParser(FILE *in, const std::string &fileName, const std::string compilationUnitName);
-    AnnaParser(char *text, size_t len, const std::string &fileName, const std::string compilationUnitName);
+    // text is read from memory, a chunk at a time, into the scanner's
+    // buffer; it must outlive the parser.
+    AnnaParser(const char *text, size_t len, const std::string &fileName, const std::string compilationUnitName);
+    // Memory-maps the file at path and lexes from the mapping
+    AnnaParser(const std::string &path, const std::string compilationUnitName);
     virtual ~AnnaParser();
 
     // FIXME: Change reutrn type
     static void ParseText(gcString text);
 
+    // Null when the source could not be opened or read
     gcnCompilationUnit parse();
 
-    void printErrors()
-    {
-        while (!errorStreams.empty()) {
-            std::cout << errorStreams.top()->str();
-            errorStreams.pop();
-        }
-    }
+    // Parses again after removed bytes at offset in the source of
+    // previous, the last tree this parser returned, were replaced with
+    // inserted. Only declarations the edit can reach are parsed again;
+    // the others are taken from previous, and copied if they moved to
+    // other rows. previous itself is left as it was. An offset past the
+    // end of the source is reported and gives null, with nothing changed;
+    // removed is cut short at the end.
+    gcnCompilationUnit reparse(gcnCompilationUnit previous, size_t offset, size_t removed, const std::string &inserted);
+
+    // Caches expression rules by token index so that alternatives retried
+    // from the same position are parsed once. Off by default.
+    void setMemoization(bool enabled);
+
+    // Parses top-level function definitions on a thread pool and puts them
+    // back in source order. The lexer runs a few definitions ahead of the
+    // parser to hand them out. Off by default.
+    void setParallel(bool enabled);
+
+    // Expressions and statements nested deeper than depth fail with a
+    // diagnostic instead of overflowing the stack. 1000 by default.
+    void setMaxDepth(int depth);
+
+    // True when the source could not be read, the last reparse() was given
+    // an edit past the end of the source, the lexer stopped at a character
+    // it does not know, or parsing produced diagnostics that printErrors()
+    // would show
+    bool hasErrors() const { return _inputFailed || _editFailed || _lexFailed || !_diagnostics.empty(); }
+    void printErrors();
 
 protected:
+    // A parser over a copy of one definition's tokens, run on a worker.
+    // Its nodes go to arena.
+    AnnaParser(const AnnaParser &unit, TokenBuffer &&tokens, std::shared_ptr<NodeArena> arena);
+
     bool lexall();
 
     gcnEOS parseEOS();
@@ -62,13 +99,16 @@ protected:
     gcnImportDirective parseImportDirective();
     gcnFunctionIdentifier parseFunctionIdentifier();
     gcnExpression parseExpression();
-    gcnBinaryOperationExpression parseBinaryOperationExpression(int min_precedence = 0);
+    // Takes the binary operators after left, if there are any
+    gcnBinaryOperationExpression parseBinaryOperationExpression(gcnExpression left);
+    // Applies the operators that follow left and bind at least as tight
+    // as min_precedence
+    gcnExpression parseBinaryOperands(gcnExpression left, int min_precedence);
     gcnUnaryExpression parseUnaryExpression();
     gcnPrimaryExpression parsePrimaryExpression();
     gcnSimpleName parseSimpleName();
     gcnLiteral parseLiteral();
     gcnParenthesizedExpression parseParenthesizedExpression();
-    gcnBinaryOperator parseBinaryOperator();
     gcnInvocationExpression parseInvocationExpression();
     gcnArgumentList parseArgumentList();
     gcnFunctionDefinition parseFunctionDefinition();
@@ -90,59 +130,270 @@ protected:
     gcnAssignment parseAssignment();
     gcnReturnStatement parseReturnStatement();
 
-    int getPrecedence(Tokens op);
-    bool isLeftAssociative(Tokens op);
+    // Bodies of the memoized rules
+    gcnExpression parseExpressionImpl();
+    gcnUnaryExpression parseUnaryExpressionImpl();
+    gcnAssignment parseAssignmentImpl();
+
+    // Counts one level of nesting while a rule that can recurse runs
+    struct Nesting
+    {
+        explicit Nesting(AnnaParser &parser) : _parser(parser) { ++_parser._depth; }
+        ~Nesting() { --_parser._depth; }
+
+        AnnaParser &_parser;
+    };
+
+    int _maxDepth = 1000;
+    int _depth = 0;
+    // Set once tooDeep() has stopped a rule
+    bool _depthExceeded = false;
 
+    // Workers run on std::thread stacks, whose size cannot be set and can
+    // be as small as 512 KiB; a level of nesting takes up to about 1 KiB.
+    // A definition nested deeper than this is parsed again on the calling
+    // thread, so parallel and serial parses stop at the same depth.
+    static const int WorkerMaxDepth = 250;
 
-    std::vector<gcnToken> tokens;
-    unsigned int currentTokenIdx = 0;
-    gcnToken currentToken;
+    // True, with a diagnostic, when the current nesting is too deep
+    bool tooDeep(const char *caller);
 
+    // Panic-mode recovery after a failed declaration or statement. Keeps
+    // the diagnostics that got furthest and skips through the next T, or
+    // up to a `}' closing the block or a top-level declaration.
+    gcnError recover(size_t diagnosticCount, const char *expected, const char *caller, bool topLevel);
+
+
+    // A window over the token stream, filled on demand by fetchToken()
+    TokenBuffer _tokens;
+    size_t currentTokenIdx = 0;
+    bool _lexDone = false;
+    bool _lexFailed = false;
+    // The source could not be opened or read
+    bool _inputFailed = false;
+    // The last reparse() was refused, leaving the parser as it was
+    bool _editFailed = false;
+
+    // The furthest token the parser has looked at
+    size_t _furthestToken = 0;
+
+    // Lexes until the token at index is buffered; false past END
+    bool bufferToken(size_t index);
+    // bufferToken() for tokens the parser looks at, which it records
+    bool fetchToken(size_t index);
+    // The first token at or after index that is not a newline
+    size_t significantToken(size_t index);
+
+    // Moves past the next token and returns its index
+    size_t advanceToken(bool dontIgnoreNewlineT = false);
+    // Moves past the next token and returns it. END is never consumed, so
+    // at the end of input every call returns the END token; it is never
+    // null.
     gcnToken eatToken(bool dontIgnoreNewlineT = false);
 
     // Always use this signature. When there's a kind mismatch,
     // no token will be consumed.
     gcnToken eatToken(Tokens kind, const char *expected = 0, const char *caller = "", bool dontIgnoreNewlineT = false);
 
-    gcnToken peekToken(int ahead = 0, bool dontIgnoreNewlineT = false);
-    void revertToken(unsigned int index);
+    Tokens peekToken(int ahead = 0, bool dontIgnoreNewlineT = false);
+    void revertToken(size_t index);
+
+
+    // Parser status stack. A mark is the token cursor and the number of
+    // diagnostics at the time it was pushed. Popping after a successful
+    // attempt drops the diagnostics it collected; reverting keeps them.
+    // Recovered errors belong to the tree instead, so reverting drops them.
+    struct ParserMark
+    {
+        size_t tokenIdx;
+        size_t diagnosticCount;
+        size_t recoveredCount;
+    };
+
+    // The oldest mark bounds how far back the token window must reach
+    std::vector<ParserMark> parserMarks;
+
+    // A token mismatch, kept unformatted until printErrors(). Most are
+    // dropped when a speculative attempt succeeds some other way.
+    struct Diagnostic
+    {
+        Tokens found;
+        uint32_t offset;
+        uint32_t length;
+        int row;
+        int col;
+        const char *expected;
+        const char *caller;
+    };
+
+    std::vector<Diagnostic> _diagnostics;
+    // Diagnostics of error nodes in the tree, in source order
+    std::vector<Diagnostic> _recovered;
+
+    void printDiagnostic(const Diagnostic &diagnostic, std::stringstream &logstream);
+
+    // Packrat memo, keyed by rule and token index
+    enum MemoRule : unsigned
+    {
+        MemoExpression,
+        MemoUnaryExpression,
+        MemoAssignment
+    };
+
+    struct MemoEntry
+    {
+        void *node;
+        size_t end;
+        size_t diagnosticBegin;
+        size_t diagnosticEnd;
+    };
 
+    bool _memoize = false;
+    std::unordered_map<uint64_t, MemoEntry> _memo;
+    std::vector<Diagnostic> _memoDiagnostics;
 
-    // Parser status stacks
-    std::stack<unsigned int> tokenIdxStack;
-    std::stack<std::shared_ptr<std::stringstream>> errorStreams;
+    void clearMemo();
+    void recallMemo(const MemoEntry &entry);
+    void storeMemo(uint64_t key, void *node, size_t diagnosticCount);
 
-    std::stringstream &currentErrorStream()
+    // Runs parse, the body of rule, through the memo
+    template <typename Node>
+    Node *memoized(unsigned rule, Node *(AnnaParser::*parse)())
     {
-        return *errorStreams.top();
+        if (!_memoize)
+            return (this->*parse)();
+
+        uint64_t key = (static_cast<uint64_t>(currentTokenIdx) << 6) | rule;
+        auto it = _memo.find(key);
+        if (it != _memo.end()) {
+            recallMemo(it->second);
+            return static_cast<Node *>(it->second.node);
+        }
+
+        size_t diagnosticCount = _diagnostics.size();
+        Node *result = (this->*parse)();
+        storeMemo(key, result, diagnosticCount);
+        return result;
     }
 
+    // A top-level definition parsed ahead on a worker thread. The main
+    // parser takes the result when it reaches tokens[begin], provided the
+    // worker stopped exactly at end; otherwise it parses serially.
+    struct DefinitionJob
+    {
+        size_t begin;
+        size_t end;
+        TokenBuffer tokens;
+        // Shared by the jobs of one worker
+        std::shared_ptr<NodeArena> arena;
+        gcnFunctionDefinition definition = nullptr;
+        std::vector<Diagnostic> diagnostics;
+        std::vector<Diagnostic> recovered;
+        std::vector<gcnToken> materialized;
+        std::promise<void> done;
+        std::future<void> finished;
+    };
+
+    bool _parallel = false;
+    // Queued jobs the parser has not reached yet, in source order
+    std::deque<std::shared_ptr<DefinitionJob>> _definitionJobs;
+    // Jobs no worker has started, dropped once the parser is past them;
+    // guarded by _definitionMutex, as is _closingDefinitionJobs
+    std::deque<std::shared_ptr<DefinitionJob>> _unstartedDefinitionJobs;
+    bool _closingDefinitionJobs = false;
+    std::mutex _definitionMutex;
+    std::condition_variable _definitionQueued;
+    std::vector<std::thread> _definitionWorkers;
+
+    // Where queueDefinitionJobs() goes on looking for definitions
+    size_t _scanIdx = 0;
+    size_t _scanDef = SIZE_MAX;
+    int _scanDepth = 0;
+
+    // Lexes ahead of the top-level declaration at first and queues the
+    // definitions found, until a few jobs per worker are waiting
+    void queueDefinitionJobs(size_t first);
+    void runDefinitionJobs();
+    gcnFunctionDefinition takeDefinitionJob(std::vector<gcnToken> &tokens);
+    void finishDefinitionJobs();
+
+    // A top-level declaration as parsed, kept for reparse()
+    struct Declaration
+    {
+        enum Kind
+        {
+            Import,
+            Variable,
+            Function,
+            Error
+        };
+
+        Kind kind;
+        AnnaSyntax *node;
+        // Owns node and tokens
+        std::shared_ptr<NodeArena> arena;
+        // Source span, and the end of the text lexing the tokens looked at
+        // may have read; SIZE_MAX if they include END
+        size_t begin;
+        size_t end;
+        size_t lookaheadEnd;
+        // Where the lexer stood at begin and end
+        int beginRow;
+        int beginCol;
+        int endRow;
+        int endCol;
+        std::vector<gcnToken> tokens;
+        std::vector<Diagnostic> recovered;
+    };
+
+    // Declarations after an edit that parsing may pick up again, and how
+    // far the edit moved them
+    struct Resume
+    {
+        std::vector<Declaration> declarations;
+        size_t next;
+        ptrdiff_t delta;
+    };
+
+    std::vector<Declaration> _declarations;
+    gcnCompilationUnit _unit;
+
+    void parseDeclarations(Resume *resume);
+    void addDeclaration(Declaration::Kind kind, AnnaSyntax *node, size_t first,
+                        size_t recoveredCount, std::vector<gcnToken> &&tokens);
+    bool resumeDeclarations(size_t first, Resume &resume);
+    gcnCompilationUnit buildCompilationUnit();
+
     void pushParserStatus()
     {
-        errorStreams.push(std::make_shared<std::stringstream>());
-        tokenIdxStack.push(currentTokenIdx);
+        parserMarks.push_back(ParserMark{currentTokenIdx, _diagnostics.size(), _recovered.size()});
     }
 
     void popParserStatus()
     {
-        errorStreams.pop();
-        tokenIdxStack.pop();
+        _diagnostics.resize(parserMarks.back().diagnosticCount);
+        parserMarks.pop_back();
     }
 
     void revertParserStatus()
     {
-        std::string err = errorStreams.top()->str();
-        errorStreams.pop();
-        *errorStreams.top() << err;
-        revertToken(tokenIdxStack.top());
-        tokenIdxStack.pop();
+        revertToken(parserMarks.back().tokenIdx);
+        _recovered.resize(parserMarks.back().recoveredCount);
+        parserMarks.pop_back();
     }
 
 
-    bool isNewlineT(const gcnToken &token);
 
+    // Owns the nodes and tokens of the tree being built
+    std::shared_ptr<NodeArena> _arena;
 
+    template <typename T, typename... Args>
+    T *make(Args &&... args)
+    {
+        return _arena->make<T>(std::forward<Args>(args)...);
+    }
 
+    LexerContext _lexer;
     std::string _filename;
     gcString _compilationUnitName;
     bool isPossiblePrimaryExpression();
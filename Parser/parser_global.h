@@ -80,6 +80,23 @@
 
 typedef std::shared_ptr<std::string> gcString;
 
+// Non-owning view of a range of characters, e.g. one row of the source text
+class StringRef
+{
+public:
+    StringRef() : _data(nullptr), _size(0) {}
+    StringRef(const char *data, size_t size) : _data(data), _size(size) {}
+
+    const char *data() const { return _data; }
+    size_t size() const { return _size; }
+    bool empty() const { return !_size; }
+    std::string str() const { return std::string(_data, _size); }
+
+private:
+    const char *_data;
+    size_t _size;
+};
+
 void set_log_output(FILE *out);
 extern FILE *__log_out;
 void log_print_indicators(int start, int width);
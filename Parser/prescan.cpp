@@ -0,0 +1,162 @@
+/**************************************************************************
+ * Copyright (c) 2015 Afa.L Cheng <afa@afa.moe>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ***************************************************************************/
+
+#include "prescan.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define PRESCAN_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PRESCAN_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+static inline unsigned first_bit(unsigned mask)
+{
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+}
+
+static inline unsigned last_bit(unsigned mask)
+{
+    unsigned long index;
+    _BitScanReverse(&index, mask);
+    return index;
+}
+
+static inline unsigned bit_count(unsigned mask)
+{
+    return __popcnt(mask);
+}
+#else
+static inline unsigned first_bit(unsigned mask)
+{
+    return __builtin_ctz(mask);
+}
+
+static inline unsigned last_bit(unsigned mask)
+{
+    return 31 - __builtin_clz(mask);
+}
+
+static inline unsigned bit_count(unsigned mask)
+{
+    return __builtin_popcount(mask);
+}
+#endif
+
+// Block primitives: load a block and compare every byte against c
+#if defined(PRESCAN_AVX2)
+static const size_t block_size = 32;
+typedef __m256i block_t;
+
+static inline block_t block_load(const char *p)
+{
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+}
+
+static inline block_t block_eq(block_t b, char c)
+{
+    return _mm256_cmpeq_epi8(b, _mm256_set1_epi8(c));
+}
+
+static inline block_t block_and(block_t a, block_t b)
+{
+    return _mm256_and_si256(a, b);
+}
+
+static inline unsigned block_mask(block_t b)
+{
+    return static_cast<unsigned>(_mm256_movemask_epi8(b));
+}
+#elif defined(PRESCAN_SSE2)
+static const size_t block_size = 16;
+typedef __m128i block_t;
+
+static inline block_t block_load(const char *p)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+}
+
+static inline block_t block_eq(block_t b, char c)
+{
+    return _mm_cmpeq_epi8(b, _mm_set1_epi8(c));
+}
+
+static inline block_t block_and(block_t a, block_t b)
+{
+    return _mm_and_si128(a, b);
+}
+
+static inline unsigned block_mask(block_t b)
+{
+    return static_cast<unsigned>(_mm_movemask_epi8(b));
+}
+#endif
+
+const char *prescan_comment_end(const char *p, const char *end)
+{
+#if defined(PRESCAN_AVX2) || defined(PRESCAN_SSE2)
+    // Test p, p + 1 and p + 2 together so every ">_<" is seen whole
+    while (end - p >= static_cast<ptrdiff_t>(block_size) + 2) {
+        unsigned found = block_mask(block_and(block_and(block_eq(block_load(p), '>'),
+                                                        block_eq(block_load(p + 1), '_')),
+                                              block_eq(block_load(p + 2), '<')));
+        if (found)
+            return p + first_bit(found) + 3;
+        p += block_size;
+    }
+#endif
+    while (end - p >= 3) {
+        if (p[0] == '>' && p[1] == '_' && p[2] == '<')
+            return p + 3;
+        ++p;
+    }
+    return nullptr;
+}
+
+size_t prescan_newlines(const char *p, const char *end, const char **lastNewline)
+{
+    size_t count = 0;
+#if defined(PRESCAN_AVX2) || defined(PRESCAN_SSE2)
+    while (end - p >= static_cast<ptrdiff_t>(block_size)) {
+        unsigned newlines = block_mask(block_eq(block_load(p), '\n'));
+        if (newlines) {
+            count += bit_count(newlines);
+            *lastNewline = p + last_bit(newlines);
+        }
+        p += block_size;
+    }
+#endif
+    for (; p < end; ++p) {
+        if (*p == '\n') {
+            ++count;
+            *lastNewline = p;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,41 @@
+/**************************************************************************
+ * Copyright (c) 2015 Afa.L Cheng <afa@afa.moe>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ***************************************************************************/
+
+#ifndef PRESCAN_H
+#define PRESCAN_H
+
+#include <cstddef>
+
+// Fast paths for the scanner. Each function looks at [p, end) only.
+// Blocks of 32 or 16 bytes are tested at once with AVX2 or SSE2 when the
+// compiler targets them, and byte by byte otherwise.
+
+// One past the first ">_<" in [p, end), or nullptr if there is none
+const char *prescan_comment_end(const char *p, const char *end);
+
+// Number of '\n' in [p, end). *lastNewline is set to the last one, or
+// left untouched when there is none.
+size_t prescan_newlines(const char *p, const char *end, const char **lastNewline);
+
+#endif // PRESCAN_H
@@ -0,0 +1,54 @@
+/**************************************************************************
+ * Copyright (c) 2015 Afa.L Cheng <afa@afa.moe>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ***************************************************************************/
+
+#include <cstring>
+
+#include "stringpool.h"
+
+size_t StringPool::Hash::operator()(const StringRef &s) const
+{
+    // FNV-1a
+    size_t h = 2166136261u;
+    for (size_t i = 0; i < s.size(); ++i) {
+        h ^= static_cast<unsigned char>(s.data()[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+bool StringPool::Equal::operator()(const StringRef &a, const StringRef &b) const
+{
+    return a.size() == b.size() && !std::memcmp(a.data(), b.data(), a.size());
+}
+
+gcString StringPool::intern(const char *text, size_t len)
+{
+    auto it = _strings.find(StringRef(text, len));
+    if (it != _strings.end())
+        return it->second;
+
+    gcString str = std::make_shared<std::string>(text, len);
+    _strings.emplace(StringRef(str->data(), str->size()), str);
+    return str;
+}
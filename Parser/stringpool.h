@@ -0,0 +1,59 @@
+/**************************************************************************
+ * Copyright (c) 2015 Afa.L Cheng <afa@afa.moe>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ***************************************************************************/
+
+
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <unordered_map>
+
+#include "parser_global.h"
+
+// Interns token text. Equal strings interned by the same pool share one
+// gcString, so they can be compared by pointer.
+class StringPool
+{
+public:
+    gcString intern(const char *text, size_t len);
+    gcString intern(const std::string &text) { return intern(text.data(), text.size()); }
+
+    size_t size() const { return _strings.size(); }
+    void clear() { _strings.clear(); }
+
+private:
+    struct Hash
+    {
+        size_t operator()(const StringRef &s) const;
+    };
+
+    struct Equal
+    {
+        bool operator()(const StringRef &a, const StringRef &b) const;
+    };
+
+    // Keys point into the pooled strings, which never move
+    std::unordered_map<StringRef, gcString, Hash, Equal> _strings;
+};
+
+#endif // STRINGPOOL_H
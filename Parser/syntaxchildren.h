@@ -0,0 +1,251 @@
+/**************************************************************************
+ * Copyright (c) 2015 Afa.L Cheng <afa@afa.moe>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ***************************************************************************/
+
+#ifndef SYNTAXCHILDREN_H
+#define SYNTAXCHILDREN_H
+
+#include "annaswitchvisitor.h"
+
+// Calls f(AnnaNode &) on each child of a node, in the order
+// SyntaxPlotterSyntaxVisitor visits them. Tokens have no children. A pass
+// that only needs the shape of the tree can recurse with this instead of
+// listing the members of every node class again.
+//
+//   forEachChild(node, [&](AnnaNode &child) { count(child); });
+template <typename F>
+class SyntaxChildren : public AnnaSwitchVisitor<SyntaxChildren<F>>
+{
+public:
+    explicit SyntaxChildren(F &f) : _f(f) {}
+
+    void visitEOS(AnnaEOSSyntax &node)
+    {
+        each(node.T);
+    }
+
+    void visitCompilationUnit(AnnaCompilationUnitSyntax &node)
+    {
+        each(node.importDirectives);
+        each(node.variableDeclarationStatements);
+        each(node.functionDefinitions);
+        each(node.errors);
+    }
+
+    void visitImportDirective(AnnaImportDirectiveSyntax &node)
+    {
+        _f(*node.IMPORT);
+        _f(*node.IDENTIFIER);
+        _f(*node.eos);
+    }
+
+    void visitFunctionIdentifier(AnnaFunctionIdentifierSyntax &node)
+    {
+        _f(*node.identifier);
+    }
+
+    void visitBinaryOperationExpression(AnnaBinaryOperationExpressionSyntax &node)
+    {
+        _f(*node.left);
+        _f(*node.op);
+        _f(*node.right);
+    }
+
+    void visitSimpleName(AnnaSimpleNameSyntax &node)
+    {
+        _f(*node.VARIABLE_IDENTIFIER);
+    }
+
+    void visitLiteral(AnnaLiteralSyntax &node)
+    {
+        _f(*node.literal);
+    }
+
+    void visitParenthesizedExpression(AnnaParenthesizedExpressionSyntax &node)
+    {
+        _f(*node.OPEN_PAREN);
+        _f(*node.expression);
+        _f(*node.CLOSE_PAREN);
+    }
+
+    void visitBinaryOperator(AnnaBinaryOperatorSyntax &node)
+    {
+        _f(*node.binOp);
+    }
+
+    void visitInvocationExpression(AnnaInvocationExpressionSyntax &node)
+    {
+        _f(*node.functionIdentifier);
+        if (node.hasOptionalPar)
+            _f(*node.OPEN_PAREN_opt);
+        if (node.hasArgs)
+            _f(*node.argumentList);
+        if (node.hasOptionalPar)
+            _f(*node.CLOSE_PAREN_opt);
+    }
+
+    void visitArgumentList(AnnaArgumentListSyntax &node)
+    {
+        each(node.argumentList);
+    }
+
+    void visitFunctionDefinition(AnnaFunctionDefinitionSyntax &node)
+    {
+        _f(*node.functionHeader);
+        _f(*node.functionBody);
+    }
+
+    void visitFunctionHeader(AnnaFunctionHeaderSyntax &node)
+    {
+        _f(*node.DEF);
+        _f(*node.USER_FUNCTION_IDENTIFIER);
+        _f(*node.OPEN_PAREN);
+        if (node.hasParameter)
+            _f(*node.formalParameterList_opt);
+        _f(*node.CLOSE_PAREN);
+    }
+
+    void visitFormalParameterList(AnnaFormalParameterListSyntax &node)
+    {
+        each(node.formalParameterList);
+    }
+
+    void visitFunctionBody(AnnaFunctionBodySyntax &node)
+    {
+        _f(*node.block);
+    }
+
+    void visitBlock(AnnaBlockSyntax &node)
+    {
+        _f(*node.OPEN_BRACE);
+        each(node.statements);
+        _f(*node.CLOSE_BRACE);
+    }
+
+    void visitVariableDeclarationStatement(AnnaVariableDeclarationStatementSyntax &node)
+    {
+        _f(*node.VAR);
+        _f(*node.VARIABLE_IDENTIFIER);
+        if (node.hasAssignment) {
+            _f(*node.EQ_opt);
+            _f(*node.primaryExpression_opt);
+        }
+        _f(*node.EOS);
+    }
+
+    void visitEmptyStatement(AnnaEmptyStatementSyntax &node)
+    {
+        if (node.has_eos)
+            _f(*node.eos_opt);
+    }
+
+    void visitExpressionStatement(AnnaExpressionStatementSyntax &node)
+    {
+        _f(*node.statementExpression);
+        _f(*node.eos);
+    }
+
+    void visitStatementExpression(AnnaStatementExpressionSyntax &node)
+    {
+        if (node.isAssignment)
+            _f(*node.assignment_opt);
+        else
+            _f(*node.invocationExpression_opt);
+    }
+
+    void visitIfStatement(AnnaIfStatementSyntax &node)
+    {
+        _f(*node.IF);
+        _f(*node.OPEN_PAREN);
+        _f(*node.condition);
+        _f(*node.CLOSE_PAREN);
+        _f(*node.embeddedStatement);
+        if (node.hasElse) {
+            _f(*node.ELSE_opt);
+            _f(*node.elseStatement_opt);
+        }
+    }
+
+    void visitWhileStatement(AnnaWhileStatementSyntax &node)
+    {
+        _f(*node.WHILE);
+        _f(*node.OPEN_PAREN);
+        _f(*node.condition);
+        _f(*node.CLOSE_PAREN);
+        _f(*node.while_body);
+    }
+
+    void visitAssignment(AnnaAssignmentSyntax &node)
+    {
+        _f(*node.left);
+        _f(*node.EQ);
+        _f(*node.right);
+    }
+
+    void visitFormalParameter(AnnaFormalParameterSyntax &node)
+    {
+        _f(*node.VARIABLE_IDENTIFIER);
+    }
+
+    void visitReturnStatement(AnnaReturnStatementSyntax &node)
+    {
+        _f(*node.RETURN);
+        if (node.hasExpr)
+            _f(*node.expression);
+        _f(*node.eos);
+    }
+
+    void visitError(AnnaErrorSyntax &node)
+    {
+        each(node.tokens);
+    }
+
+private:
+    template <typename T>
+    void each(const std::vector<T> &nodes)
+    {
+        for (auto node : nodes)
+            _f(*node);
+    }
+
+    template <typename T>
+    void each(const AnnaSeperatedList<T> &list)
+    {
+        for (auto couple : list.list) {
+            if (couple.node)
+                _f(*couple.node);
+            if (couple.COMMA)
+                _f(*couple.COMMA);
+        }
+    }
+
+    F &_f;
+};
+
+template <typename F>
+void forEachChild(AnnaNode &node, F f)
+{
+    SyntaxChildren<F>(f).visit(node);
+}
+
+#endif // SYNTAXCHILDREN_H
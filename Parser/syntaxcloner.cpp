@@ -0,0 +1,257 @@
+/**************************************************************************
+ * Copyright (c) 2015 Afa.L Cheng <afa@afa.moe>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ***************************************************************************/
+
+#include <cassert>
+
+#include "syntaxcloner.h"
+
+AnnaToken *SyntaxCloner::cloneToken(AnnaToken *token)
+{
+    if (!token)
+        return nullptr;
+
+    AnnaToken *&copy = _tokens[token];
+    if (!copy)
+        copy = token->clone(_arena, _lines);
+    return copy;
+}
+
+AnnaNode *SyntaxCloner::visitNode(AnnaNode &node)
+{
+    // A compilation unit is never carried over
+    (void)node;
+    assert(false);
+    return nullptr;
+}
+
+AnnaNode *SyntaxCloner::visitEOS(AnnaEOSSyntax &node)
+{
+    AnnaEOSSyntax *copy = this->copy(node);
+    cloneAll(copy->T);
+    return copy;
+}
+
+AnnaNode *SyntaxCloner::visitImportDirective(AnnaImportDirectiveSyntax &node)
+{
+    AnnaImportDirectiveSyntax *copy = this->copy(node);
+    copy->IMPORT = clone(node.IMPORT);
+    copy->IDENTIFIER = clone(node.IDENTIFIER);
+    copy->eos = clone(node.eos);
+    return copy;
+}
+
+AnnaNode *SyntaxCloner::visitFunctionIdentifier(AnnaFunctionIdentifierSyntax &node)
+{
+    AnnaFunctionIdentifierSyntax *copy = this->copy(node);
+    copy->identifier = clone(node.identifier);
+    return copy;
+}
+
+AnnaNode *SyntaxCloner::visitBinaryOperationExpression(AnnaBinaryOperationExpressionSyntax &node)
+{
+    AnnaBinaryOperationExpressionSyntax *copy = this->copy(node);
+    copy->left = clone(node.left);
+    copy->op = clone(node.op);
+    copy->right = clone(node.right);
+    return copy;
+}
+
+AnnaNode *SyntaxCloner::visitSimpleName(AnnaSimpleNameSyntax &node)
+{
+    AnnaSimpleNameSyntax *copy = this->copy(node);
+    copy->VARIABLE_IDENTIFIER = clone(node.VARIABLE_IDENTIFIER);
+    return copy;
+}
+
+AnnaNode *SyntaxCloner::visitLiteral(AnnaLiteralSyntax &node)
+{
+    AnnaLiteralSyntax *copy = this->copy(node);
+    copy->literal = clone(node.literal);
+    return copy;
+}
+
+AnnaNode *SyntaxCloner::visitParenthesizedExpression(AnnaParenthesizedExpressionSyntax &node)
+{
+    AnnaParenthesizedExpressionSyntax *copy = this->copy(node);
+    copy->OPEN_PAREN = clone(node.OPEN_PAREN);
+    copy->expression = clone(node.expression);
+    copy->CLOSE_PAREN = clone(node.CLOSE_PAREN);
+    return copy;
+}
+
+AnnaNode *SyntaxCloner::visitBinaryOperator(AnnaBinaryOperatorSyntax &node)
+{
+    AnnaBinaryOperatorSyntax *copy = this->copy(node);
+    copy->binOp = clone(node.binOp);
+    return copy;
+}
+
+AnnaNode *SyntaxCloner::visitInvocationExpression(AnnaInvocationExpressionSyntax &node)
+{
+    AnnaInvocationExpressionSyntax *copy = this->copy(node);
+    copy->functionIdentifier = clone(node.functionIdentifier);
+    copy->OPEN_PAREN_opt = clone(node.OPEN_PAREN_opt);
+    copy->argumentList = clone(node.argumentList);
+    copy->CLOSE_PAREN_opt = clone(node.CLOSE_PAREN_opt);
+    return copy;
+}
+
+AnnaNode *SyntaxCloner::visitArgumentList(AnnaArgumentListSyntax &node)
+{
+    AnnaArgumentListSyntax *copy = this->copy(node);
+    cloneList(copy->argumentList);
+    return copy;
+}
+
+AnnaNode *SyntaxCloner::visitFunctionDefinition(AnnaFunctionDefinitionSyntax &node)
+{
+    AnnaFunctionDefinitionSyntax *copy = this->copy(node);
+    copy->functionHeader = clone(node.functionHeader);
+    copy->functionBody = clone(node.functionBody);
+    return copy;
+}
+
+AnnaNode *SyntaxCloner::visitFunctionHeader(AnnaFunctionHeaderSyntax &node)
+{
+    AnnaFunctionHeaderSyntax *copy = this->copy(node);
+    copy->DEF = clone(node.DEF);
+    copy->USER_FUNCTION_IDENTIFIER = clone(node.USER_FUNCTION_IDENTIFIER);
+    copy->OPEN_PAREN = clone(node.OPEN_PAREN);
+    copy->formalParameterList_opt = clone(node.formalParameterList_opt);
+    copy->CLOSE_PAREN = clone(node.CLOSE_PAREN);
+    return copy;
+}
+
+AnnaNode *SyntaxCloner::visitFormalParameterList(AnnaFormalParameterListSyntax &node)
+{
+    AnnaFormalParameterListSyntax *copy = this->copy(node);
+    cloneList(copy->formalParameterList);
+    return copy;
+}
+
+AnnaNode *SyntaxCloner::visitFunctionBody(AnnaFunctionBodySyntax &node)
+{
+    AnnaFunctionBodySyntax *copy = this->copy(node);
+    copy->block = clone(node.block);
+    return copy;
+}
+
+AnnaNode *SyntaxCloner::visitBlock(AnnaBlockSyntax &node)
+{
+    AnnaBlockSyntax *copy = this->copy(node);
+    copy->OPEN_BRACE = clone(node.OPEN_BRACE);
+    cloneAll(copy->statements);
+    copy->CLOSE_BRACE = clone(node.CLOSE_BRACE);
+    return copy;
+}
+
+AnnaNode *SyntaxCloner::visitVariableDeclarationStatement(AnnaVariableDeclarationStatementSyntax &node)
+{
+    AnnaVariableDeclarationStatementSyntax *copy = this->copy(node);
+    copy->VAR = clone(node.VAR);
+    copy->VARIABLE_IDENTIFIER = clone(node.VARIABLE_IDENTIFIER);
+    copy->EOS = clone(node.EOS);
+    copy->EQ_opt = clone(node.EQ_opt);
+    copy->primaryExpression_opt = clone(node.primaryExpression_opt);
+    return copy;
+}
+
+AnnaNode *SyntaxCloner::visitEmptyStatement(AnnaEmptyStatementSyntax &node)
+{
+    AnnaEmptyStatementSyntax *copy = this->copy(node);
+    copy->eos_opt = clone(node.eos_opt);
+    return copy;
+}
+
+AnnaNode *SyntaxCloner::visitExpressionStatement(AnnaExpressionStatementSyntax &node)
+{
+    AnnaExpressionStatementSyntax *copy = this->copy(node);
+    copy->statementExpression = clone(node.statementExpression);
+    copy->eos = clone(node.eos);
+    return copy;
+}
+
+AnnaNode *SyntaxCloner::visitStatementExpression(AnnaStatementExpressionSyntax &node)
+{
+    AnnaStatementExpressionSyntax *copy = this->copy(node);
+    copy->invocationExpression_opt = clone(node.invocationExpression_opt);
+    copy->assignment_opt = clone(node.assignment_opt);
+    return copy;
+}
+
+AnnaNode *SyntaxCloner::visitIfStatement(AnnaIfStatementSyntax &node)
+{
+    AnnaIfStatementSyntax *copy = this->copy(node);
+    copy->IF = clone(node.IF);
+    copy->OPEN_PAREN = clone(node.OPEN_PAREN);
+    copy->condition = clone(node.condition);
+    copy->CLOSE_PAREN = clone(node.CLOSE_PAREN);
+    copy->embeddedStatement = clone(node.embeddedStatement);
+    copy->ELSE_opt = clone(node.ELSE_opt);
+    copy->elseStatement_opt = clone(node.elseStatement_opt);
+    return copy;
+}
+
+AnnaNode *SyntaxCloner::visitWhileStatement(AnnaWhileStatementSyntax &node)
+{
+    AnnaWhileStatementSyntax *copy = this->copy(node);
+    copy->WHILE = clone(node.WHILE);
+    copy->OPEN_PAREN = clone(node.OPEN_PAREN);
+    copy->condition = clone(node.condition);
+    copy->CLOSE_PAREN = clone(node.CLOSE_PAREN);
+    copy->while_body = clone(node.while_body);
+    return copy;
+}
+
+AnnaNode *SyntaxCloner::visitAssignment(AnnaAssignmentSyntax &node)
+{
+    AnnaAssignmentSyntax *copy = this->copy(node);
+    copy->left = clone(node.left);
+    copy->EQ = clone(node.EQ);
+    copy->right = clone(node.right);
+    return copy;
+}
+
+AnnaNode *SyntaxCloner::visitFormalParameter(AnnaFormalParameterSyntax &node)
+{
+    AnnaFormalParameterSyntax *copy = this->copy(node);
+    copy->VARIABLE_IDENTIFIER = clone(node.VARIABLE_IDENTIFIER);
+    return copy;
+}
+
+AnnaNode *SyntaxCloner::visitReturnStatement(AnnaReturnStatementSyntax &node)
+{
+    AnnaReturnStatementSyntax *copy = this->copy(node);
+    copy->RETURN = clone(node.RETURN);
+    copy->expression = clone(node.expression);
+    copy->eos = clone(node.eos);
+    return copy;
+}
+
+AnnaNode *SyntaxCloner::visitError(AnnaErrorSyntax &node)
+{
+    AnnaErrorSyntax *copy = this->copy(node);
+    cloneAll(copy->tokens);
+    return copy;
+}
@@ -0,0 +1,116 @@
+/**************************************************************************
+ * Copyright (c) 2015 Afa.L Cheng <afa@afa.moe>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ***************************************************************************/
+
+#ifndef SYNTAXCLONER_H
+#define SYNTAXCLONER_H
+
+#include <unordered_map>
+
+#include "annaswitchvisitor.h"
+#include "nodearena.h"
+
+// Copies subtrees into another arena, with their tokens lines rows further
+// down. reparse() carries declarations over to the new tree this way, so
+// the tree they came from is left as it was.
+class SyntaxCloner : public AnnaSwitchVisitor<SyntaxCloner, AnnaNode *>
+{
+public:
+    SyntaxCloner(NodeArena &arena, int lines) : _arena(arena), _lines(lines) {}
+
+    template <typename T>
+    T *clone(T *node)
+    {
+        return node ? static_cast<T *>(visit(*node)) : nullptr;
+    }
+
+    // The copy of token, made once however often it is asked for
+    AnnaToken *cloneToken(AnnaToken *token);
+
+    AnnaNode *visitNode(AnnaNode &node);
+
+    // Syntax Nodes
+    AnnaNode *visitEOS(AnnaEOSSyntax &node);
+    AnnaNode *visitImportDirective(AnnaImportDirectiveSyntax &node);
+    AnnaNode *visitFunctionIdentifier(AnnaFunctionIdentifierSyntax &node);
+    AnnaNode *visitBinaryOperationExpression(AnnaBinaryOperationExpressionSyntax &node);
+    AnnaNode *visitSimpleName(AnnaSimpleNameSyntax &node);
+    AnnaNode *visitLiteral(AnnaLiteralSyntax &node);
+    AnnaNode *visitParenthesizedExpression(AnnaParenthesizedExpressionSyntax &node);
+    AnnaNode *visitBinaryOperator(AnnaBinaryOperatorSyntax &node);
+    AnnaNode *visitInvocationExpression(AnnaInvocationExpressionSyntax &node);
+    AnnaNode *visitArgumentList(AnnaArgumentListSyntax &node);
+    AnnaNode *visitFunctionDefinition(AnnaFunctionDefinitionSyntax &node);
+    AnnaNode *visitFunctionHeader(AnnaFunctionHeaderSyntax &node);
+    AnnaNode *visitFormalParameterList(AnnaFormalParameterListSyntax &node);
+    AnnaNode *visitFunctionBody(AnnaFunctionBodySyntax &node);
+    AnnaNode *visitBlock(AnnaBlockSyntax &node);
+    AnnaNode *visitVariableDeclarationStatement(AnnaVariableDeclarationStatementSyntax &node);
+    AnnaNode *visitEmptyStatement(AnnaEmptyStatementSyntax &node);
+    AnnaNode *visitExpressionStatement(AnnaExpressionStatementSyntax &node);
+    AnnaNode *visitStatementExpression(AnnaStatementExpressionSyntax &node);
+    AnnaNode *visitIfStatement(AnnaIfStatementSyntax &node);
+    AnnaNode *visitWhileStatement(AnnaWhileStatementSyntax &node);
+    AnnaNode *visitAssignment(AnnaAssignmentSyntax &node);
+    AnnaNode *visitFormalParameter(AnnaFormalParameterSyntax &node);
+    AnnaNode *visitReturnStatement(AnnaReturnStatementSyntax &node);
+    AnnaNode *visitError(AnnaErrorSyntax &node);
+
+    // Tokens
+    AnnaNode *visitToken(AnnaToken &node) { return cloneToken(&node); }
+    AnnaNode *visitIdentifierToken(IdentifierToken &node) { return cloneToken(&node); }
+    AnnaNode *visitRealToken(RealToken &node) { return cloneToken(&node); }
+    AnnaNode *visitIntegerToken(IntegerToken &node) { return cloneToken(&node); }
+    AnnaNode *visitBooleanToken(BooleanToken &node) { return cloneToken(&node); }
+    AnnaNode *visitStringToken(StringToken &node) { return cloneToken(&node); }
+
+private:
+    // A shallow copy, whose children the caller replaces
+    template <typename T>
+    T *copy(T &node)
+    {
+        return _arena.make<T>(node);
+    }
+
+    template <typename T>
+    void cloneAll(std::vector<T> &nodes)
+    {
+        for (T &node : nodes)
+            node = clone(node);
+    }
+
+    template <typename T>
+    void cloneList(AnnaSeperatedList<T> &list)
+    {
+        for (auto &couple : list.list) {
+            couple.node = clone(couple.node);
+            couple.COMMA = clone(couple.COMMA);
+        }
+    }
+
+    NodeArena &_arena;
+    int _lines;
+    std::unordered_map<AnnaToken *, AnnaToken *> _tokens;
+};
+
+#endif // SYNTAXCLONER_H
@@ -0,0 +1,272 @@
+/**************************************************************************
+ * Copyright (c) 2015 Afa.L Cheng <afa@afa.moe>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ***************************************************************************/
+
+#include <algorithm>
+
+#include "tokenbuffer.h"
+
+void TokenBuffer::clear()
+{
+    _kinds.clear();
+    _flags.clear();
+    _offsets.clear();
+    _lengths.clear();
+    _positions.clear();
+    _values.clear();
+    _skips.clear();
+    _newlineRun = SIZE_MAX;
+    _literals.clear();
+    _commentTokens.clear();
+    _comments.clear();
+    _materialized.clear();
+    _base = 0;
+    _discarded = 0;
+    _literalBase = 0;
+}
+
+void TokenBuffer::reserve(size_t n)
+{
+    _kinds.reserve(n);
+    _flags.reserve(n);
+    _offsets.reserve(n);
+    _lengths.reserve(n);
+    _positions.reserve(n);
+    _values.reserve(n);
+    _skips.reserve(n);
+}
+
+void TokenBuffer::discard(size_t index)
+{
+    if (index <= _base + _discarded)
+        return;
+
+    _discarded = std::min(index, end()) - _base;
+    if (_discarded >= 4096 && _discarded * 2 >= _kinds.size())
+        compact();
+}
+
+TokenBuffer TokenBuffer::slice(size_t first, size_t last) const
+{
+    TokenBuffer part;
+    part._base = first;
+    part._source = _source;
+    part.reserve(last - first);
+
+    for (size_t i = first; i < last; ++i) {
+        uint8_t flags = _flags[i - _base];
+        part.push(kind(i), flags, offset(i), length(i), row(i), col(i));
+        if (flags & TextFlag) {
+            part._values.back() = static_cast<uint32_t>(part._literals.size());
+            part._literals.push_back(literal(i));
+        }
+    }
+
+    auto from = std::lower_bound(_commentTokens.begin(), _commentTokens.end(), static_cast<uint32_t>(first));
+    auto to = std::lower_bound(from, _commentTokens.end(), static_cast<uint32_t>(last));
+    part._commentTokens.assign(from, to);
+    part._comments.assign(_comments.begin() + (from - _commentTokens.begin()),
+                          _comments.begin() + (to - _commentTokens.begin()));
+    return part;
+}
+
+void TokenBuffer::compact()
+{
+    size_t n = _discarded;
+
+    size_t literals = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (_flags[i] & TextFlag)
+            ++literals;
+    }
+
+    _kinds.erase(_kinds.begin(), _kinds.begin() + n);
+    _flags.erase(_flags.begin(), _flags.begin() + n);
+    _offsets.erase(_offsets.begin(), _offsets.begin() + n);
+    _lengths.erase(_lengths.begin(), _lengths.begin() + n);
+    _positions.erase(_positions.begin(), _positions.begin() + n);
+    _values.erase(_values.begin(), _values.begin() + n);
+    _skips.erase(_skips.begin(), _skips.begin() + n);
+
+    _literals.erase(_literals.begin(), _literals.begin() + literals);
+    _literalBase += literals;
+
+    _base += n;
+    _discarded = 0;
+
+    auto firstLive = std::lower_bound(_commentTokens.begin(), _commentTokens.end(), static_cast<uint32_t>(_base));
+    size_t comments = firstLive - _commentTokens.begin();
+    _commentTokens.erase(_commentTokens.begin(), firstLive);
+    _comments.erase(_comments.begin(), _comments.begin() + comments);
+
+    _materialized.erase(_materialized.begin(), firstMaterialized(_base));
+}
+
+size_t TokenBuffer::push(Tokens kind, uint8_t flags, uint32_t offset, uint32_t length, int row, int col)
+{
+    _kinds.push_back(static_cast<int16_t>(kind));
+    _flags.push_back(flags);
+    _offsets.push_back(offset);
+    _lengths.push_back(length);
+    _positions.push_back((static_cast<uint64_t>(static_cast<uint32_t>(row)) << 32) | static_cast<uint32_t>(col));
+    _values.push_back(0);
+    _skips.push_back(0);
+
+    size_t index = end() - 1;
+    if (flags & NewlineFlag) {
+        if (_newlineRun == SIZE_MAX)
+            _newlineRun = index;
+    } else if (_newlineRun != SIZE_MAX) {
+        // Close the run: each newline in it now knows how far to skip
+        for (size_t i = std::max(_newlineRun, _base); i < index; ++i)
+            _skips[i - _base] = static_cast<uint32_t>(index - i);
+        _newlineRun = SIZE_MAX;
+    }
+    return index;
+}
+
+TokenBuffer::Literal &TokenBuffer::pushLiteral(Tokens kind, uint32_t offset, uint32_t length, int row, int col, gcString text)
+{
+    push(kind, TextFlag, offset, length, row, col);
+    _values.back() = static_cast<uint32_t>(_literalBase + _literals.size());
+    _literals.emplace_back();
+    _literals.back().text = text;
+    _literals.back().real = 0;
+    return _literals.back();
+}
+
+size_t TokenBuffer::append(Tokens kind, uint32_t offset, uint32_t length, int row, int col, bool newline)
+{
+    return push(kind, newline ? NewlineFlag : 0, offset, length, row, col);
+}
+
+size_t TokenBuffer::appendText(Tokens kind, uint32_t offset, uint32_t length, int row, int col, gcString text)
+{
+    pushLiteral(kind, offset, length, row, col, text);
+    return end() - 1;
+}
+
+size_t TokenBuffer::appendInteger(uint32_t offset, uint32_t length, int row, int col, gcString text, int value)
+{
+    pushLiteral(INTEGER, offset, length, row, col, text).integer = value;
+    return end() - 1;
+}
+
+size_t TokenBuffer::appendReal(uint32_t offset, uint32_t length, int row, int col, gcString text, double value)
+{
+    pushLiteral(REAL, offset, length, row, col, text).real = value;
+    return end() - 1;
+}
+
+size_t TokenBuffer::appendBoolean(uint32_t offset, uint32_t length, int row, int col, gcString text, bool value)
+{
+    pushLiteral(BOOLEAN, offset, length, row, col, text).boolean = value;
+    return end() - 1;
+}
+
+void TokenBuffer::appendComment(size_t index, size_t offset, size_t length)
+{
+    _commentTokens.push_back(static_cast<uint32_t>(index));
+    _comments.push_back(SourceSpan{offset, length});
+}
+
+gcString TokenBuffer::text(size_t i) const
+{
+    if (_flags[i - _base] & TextFlag)
+        return literal(i).text;
+    if (isNewline(i))
+        return AnnaToken::newlineText();
+    return AnnaToken::spellingText(kind(i));
+}
+
+std::vector<std::string> TokenBuffer::trailingComments(size_t i) const
+{
+    auto range = std::equal_range(_commentTokens.begin(), _commentTokens.end(), static_cast<uint32_t>(i));
+
+    std::vector<std::string> comments;
+    for (auto it = range.first; it != range.second; ++it) {
+        const SourceSpan &span = _comments[it - _commentTokens.begin()];
+        comments.emplace_back(_source + span.offset, span.length);
+    }
+    return comments;
+}
+
+std::vector<std::pair<size_t, gcnToken>>::const_iterator TokenBuffer::firstMaterialized(size_t i) const
+{
+    return std::lower_bound(_materialized.begin(), _materialized.end(), i,
+                            [](const std::pair<size_t, gcnToken> &entry, size_t index) { return entry.first < index; });
+}
+
+gcnToken TokenBuffer::token(size_t i)
+{
+    // The common case: the parser eats past the last token it created
+    if (_materialized.empty() || _materialized.back().first < i) {
+        gcnToken tok = materialize(i);
+        _materialized.emplace_back(i, tok);
+        return tok;
+    }
+
+    auto it = firstMaterialized(i);
+    if (it->first == i)
+        return it->second;
+
+    gcnToken tok = materialize(i);
+    _materialized.emplace(it, i, tok);
+    return tok;
+}
+
+std::vector<gcnToken> TokenBuffer::materialized(size_t first, size_t last) const
+{
+    std::vector<gcnToken> tokens;
+    for (auto it = firstMaterialized(first); it != _materialized.end() && it->first < last; ++it)
+        tokens.push_back(it->second);
+    return tokens;
+}
+
+gcnToken TokenBuffer::materialize(size_t i) const
+{
+    Tokens k = kind(i);
+    int r = row(i);
+    int c = col(i);
+    int width = static_cast<int>(length(i));
+    const TokenComments *comments = nullptr;
+    if (std::binary_search(_commentTokens.begin(), _commentTokens.end(), static_cast<uint32_t>(i)))
+        comments = _arena->make<TokenComments>(trailingComments(i));
+
+    switch (k) {
+        case USER_FUNCTION_IDENTIFIER:
+        case IDENTIFIER:
+        case VARIABLE_IDENTIFIER:
+            return _arena->make<IdentifierToken>(k, r, c, width, literal(i).text, comments);
+        case STRING:
+            return _arena->make<StringToken>(k, r, c, width, literal(i).text, comments);
+        case REAL:
+            return _arena->make<RealToken>(k, r, c, width, literal(i).text, literal(i).real, comments);
+        case INTEGER:
+            return _arena->make<IntegerToken>(k, r, c, width, literal(i).text, literal(i).integer, comments);
+        case BOOLEAN:
+            return _arena->make<BooleanToken>(k, r, c, width, literal(i).text, literal(i).boolean, comments);
+        default:
+            return _arena->make<AnnaToken>(k, r, c, width, comments, isNewline(i));
+    }
+}
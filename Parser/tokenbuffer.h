@@ -0,0 +1,149 @@
+/**************************************************************************
+ * Copyright (c) 2015 Afa.L Cheng <afa@afa.moe>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ***************************************************************************/
+
+#ifndef TOKENBUFFER_H
+#define TOKENBUFFER_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "parser_global.h"
+#include "annatoken.h"
+#include "lexertoken.h"
+#include "nodearena.h"
+
+// Token stream stored as parallel arrays. Literal values, text and
+// comments live in side tables; AnnaToken objects are only created when
+// the parser hands a token to the AST.
+//
+// Indices are absolute positions in the stream. The buffer holds the
+// window [begin(), end()); tokens before begin() have been discarded.
+class TokenBuffer
+{
+public:
+    size_t begin() const { return _base; }
+    size_t end() const { return _base + _kinds.size(); }
+    bool empty() const { return _kinds.empty(); }
+    void clear();
+    void reserve(size_t n);
+
+    // Tokens before index will not be accessed again. Storage is
+    // reclaimed once the dead prefix outweighs the live window.
+    void discard(size_t index);
+
+    // A buffer holding copies of the tokens in [first, last), at the same
+    // indices
+    TokenBuffer slice(size_t first, size_t last) const;
+
+    // Appending returns the index of the new token
+    size_t append(Tokens kind, uint32_t offset, uint32_t length, int row, int col, bool newline = false);
+    size_t appendText(Tokens kind, uint32_t offset, uint32_t length, int row, int col, gcString text);
+    size_t appendInteger(uint32_t offset, uint32_t length, int row, int col, gcString text, int value);
+    size_t appendReal(uint32_t offset, uint32_t length, int row, int col, gcString text, double value);
+    size_t appendBoolean(uint32_t offset, uint32_t length, int row, int col, gcString text, bool value);
+    // Attaches the comment at [offset, offset + length) of the source to
+    // the token at index
+    void appendComment(size_t index, size_t offset, size_t length);
+    // Comment text is copied out of source when a token is materialized
+    void setSource(const char *source) { _source = source; }
+    // Materialized tokens are allocated from arena
+    void setArena(NodeArena *arena) { _arena = arena; }
+
+    Tokens kind(size_t i) const { return static_cast<Tokens>(_kinds[i - _base]); }
+    bool isNewline(size_t i) const { return _flags[i - _base] & NewlineFlag; }
+    // The first token at or after i that is not a newline, or end() while
+    // the run of newlines holding i is still open
+    size_t significant(size_t i) const { return i >= _newlineRun ? end() : i + _skips[i - _base]; }
+    uint32_t offset(size_t i) const { return _offsets[i - _base]; }
+    uint32_t length(size_t i) const { return _lengths[i - _base]; }
+    int row(size_t i) const { return static_cast<int>(_positions[i - _base] >> 32); }
+    int col(size_t i) const { return static_cast<int>(_positions[i - _base] & 0xffffffffu); }
+
+    gcString text(size_t i) const;
+    std::vector<std::string> trailingComments(size_t i) const;
+
+    // The AnnaToken for index i, created on first use and cached
+    gcnToken token(size_t i);
+    // The tokens in [first, last) that have been created so far
+    std::vector<gcnToken> materialized(size_t first, size_t last) const;
+
+private:
+    enum Flags : uint8_t
+    {
+        NewlineFlag = 1,
+        TextFlag = 2
+    };
+
+    struct Literal
+    {
+        gcString text;
+        union {
+            int integer;
+            double real;
+            bool boolean;
+        };
+    };
+
+    const Literal &literal(size_t i) const { return _literals[_values[i - _base] - _literalBase]; }
+    void compact();
+
+    size_t push(Tokens kind, uint8_t flags, uint32_t offset, uint32_t length, int row, int col);
+    Literal &pushLiteral(Tokens kind, uint32_t offset, uint32_t length, int row, int col, gcString text);
+    gcnToken materialize(size_t i) const;
+    // The first created token at or after index i
+    std::vector<std::pair<size_t, gcnToken>>::const_iterator firstMaterialized(size_t i) const;
+
+    std::vector<int16_t> _kinds;
+    std::vector<uint8_t> _flags;
+    std::vector<uint32_t> _offsets;
+    std::vector<uint32_t> _lengths;
+    // Row in the high word, column in the low word
+    std::vector<uint64_t> _positions;
+    // Literal number for tokens that carry text; _literals holds the
+    // literals from _literalBase on
+    std::vector<uint32_t> _values;
+    // Distance to the next token that is not a newline
+    std::vector<uint32_t> _skips;
+    // First newline of the run at the end of the buffer, if any
+    size_t _newlineRun = SIZE_MAX;
+
+    std::vector<Literal> _literals;
+    size_t _literalBase = 0;
+
+    // Sorted by token index, since tokens are appended in order
+    std::vector<uint32_t> _commentTokens;
+    std::vector<SourceSpan> _comments;
+    const char *_source = nullptr;
+
+    NodeArena *_arena = nullptr;
+    // Tokens created so far, sorted by index. Most are created in order,
+    // as the parser eats them, and newlines usually never are.
+    std::vector<std::pair<size_t, gcnToken>> _materialized;
+
+    size_t _base = 0;
+    size_t _discarded = 0;
+};
+
+#endif // TOKENBUFFER_H
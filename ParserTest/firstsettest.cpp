@@ -0,0 +1,572 @@
+/**************************************************************************
+ * Copyright (c) 2015 Afa.L Cheng <afa@afa.moe>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ***************************************************************************/
+
+// Checks the FIRST-set dispatch of the parser against anna.ebnf.
+//
+// The grammar is read from anna.ebnf, and FIRST sets are computed from
+// it, together with a shortest sentence of each rule that starts with a
+// given token. For each alternative of the rules the parser picks by one
+// token (primary expression, statement expression, embedded statement
+// and statement), every token in the alternative's FIRST set must lead
+// the parser to that alternative, and tokens outside the rule's FIRST set
+// must not parse at all.
+
+#include <cctype>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "parser.h"
+#include "testing.h"
+
+#ifndef ANNA_EBNF
+#define ANNA_EBNF "anna.ebnf"
+#endif
+
+// An EBNF expression
+struct Expr
+{
+    enum Type
+    {
+        Terminal,
+        Nonterminal,
+        Alternation,
+        Sequence,
+        Option,
+        Repetition
+    };
+
+    Type type;
+    std::string name;
+    std::vector<Expr> items;
+};
+
+class GrammarReader
+{
+public:
+    explicit GrammarReader(const std::string &text) : _text(text) {}
+
+    std::map<std::string, Expr> read()
+    {
+        std::map<std::string, Expr> rules;
+        while (skip()) {
+            std::string name = word();
+            expect('=');
+            rules[name] = alternation();
+            expect(';');
+        }
+        return rules;
+    }
+
+private:
+    // Skips blanks and (* comments *); false at the end of the text
+    bool skip()
+    {
+        for (;;) {
+            while (_pos < _text.size() && std::isspace(static_cast<unsigned char>(_text[_pos])))
+                ++_pos;
+            if (_text.compare(_pos, 2, "(*") != 0)
+                return _pos < _text.size();
+            size_t end = _text.find("*)", _pos + 2);
+            if (end == std::string::npos)
+                throw std::runtime_error("unterminated comment");
+            _pos = end + 2;
+        }
+    }
+
+    bool peek(char c)
+    {
+        return skip() && _text[_pos] == c;
+    }
+
+    void expect(char c)
+    {
+        if (!peek(c))
+            throw std::runtime_error(std::string("expected ") + c + " at offset " + std::to_string(_pos));
+        ++_pos;
+    }
+
+    // A name of one or more words separated by blanks
+    std::string word()
+    {
+        std::string name;
+        while (skip() && (std::isalpha(static_cast<unsigned char>(_text[_pos])) || _text[_pos] == '_')) {
+            if (!name.empty())
+                name += ' ';
+            while (_pos < _text.size() && (std::isalnum(static_cast<unsigned char>(_text[_pos])) || _text[_pos] == '_'))
+                name += _text[_pos++];
+        }
+        if (name.empty())
+            throw std::runtime_error("expected a name at offset " + std::to_string(_pos));
+        return name;
+    }
+
+    Expr alternation()
+    {
+        Expr alt{Expr::Alternation, "", {sequence()}};
+        while (peek('|')) {
+            ++_pos;
+            alt.items.push_back(sequence());
+        }
+        return alt.items.size() == 1 ? alt.items[0] : alt;
+    }
+
+    Expr sequence()
+    {
+        Expr seq{Expr::Sequence, "", {item()}};
+        while (peek(',')) {
+            ++_pos;
+            seq.items.push_back(item());
+        }
+        return seq.items.size() == 1 ? seq.items[0] : seq;
+    }
+
+    Expr item()
+    {
+        if (peek('(') || peek('[') || peek('{')) {
+            char open = _text[_pos++];
+            Expr inner = alternation();
+            expect(open == '(' ? ')' : open == '[' ? ']' : '}');
+            if (open == '(')
+                return inner;
+            return Expr{open == '[' ? Expr::Option : Expr::Repetition, "", {inner}};
+        }
+
+        if (peek('\'')) {
+            size_t end = _text.find('\'', _pos + 1);
+            std::string quoted = _text.substr(_pos, end + 1 - _pos);
+            _pos = end + 1;
+            return Expr{Expr::Terminal, quoted, {}};
+        }
+
+        std::string name = word();
+        bool upper = true;
+        for (char c : name)
+            upper = upper && !std::islower(static_cast<unsigned char>(c));
+        return Expr{upper ? Expr::Terminal : Expr::Nonterminal, name, {}};
+    }
+
+    const std::string &_text;
+    size_t _pos = 0;
+};
+
+// Shortest sentences of the grammar, overall and starting with a given
+// terminal, found by iterating to a fixed point
+class Sentences
+{
+public:
+    typedef std::vector<std::string> Sentence;
+
+    explicit Sentences(const std::map<std::string, Expr> &rules) : _rules(rules)
+    {
+        for (const auto &rule : rules)
+            collectTerminals(rule.second);
+
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (const auto &rule : rules) {
+                changed |= improve(_shortest[rule.first], shortest(rule.second));
+                for (const std::string &terminal : _terminals)
+                    changed |= improve(_starting[rule.first][terminal], starting(rule.second, terminal));
+            }
+        }
+    }
+
+    const std::set<std::string> &terminals() const { return _terminals; }
+
+    // The terminals a sentence of rule can start with
+    std::set<std::string> first(const std::string &rule)
+    {
+        std::set<std::string> set;
+        for (const std::string &terminal : _terminals) {
+            if (_starting[rule][terminal].found)
+                set.insert(terminal);
+        }
+        return set;
+    }
+
+    // A shortest sentence of rule that starts with terminal
+    const Sentence &startingWith(const std::string &rule, const std::string &terminal)
+    {
+        return _starting[rule][terminal].sentence;
+    }
+
+private:
+    struct Best
+    {
+        bool found = false;
+        Sentence sentence;
+    };
+
+    static bool improve(Best &best, const Best &candidate)
+    {
+        if (!candidate.found || (best.found && best.sentence.size() <= candidate.sentence.size()))
+            return false;
+        best = candidate;
+        return true;
+    }
+
+    static Best concat(Best a, const Best &b)
+    {
+        if (!a.found || !b.found)
+            return Best();
+        a.sentence.insert(a.sentence.end(), b.sentence.begin(), b.sentence.end());
+        return a;
+    }
+
+    void collectTerminals(const Expr &e)
+    {
+        if (e.type == Expr::Terminal)
+            _terminals.insert(e.name);
+        for (const Expr &item : e.items)
+            collectTerminals(item);
+    }
+
+    Best shortest(const Expr &e)
+    {
+        Best best;
+        switch (e.type) {
+            case Expr::Terminal:
+                best.found = true;
+                best.sentence.push_back(e.name);
+                break;
+            case Expr::Nonterminal:
+                best = _shortest[e.name];
+                break;
+            case Expr::Alternation:
+                for (const Expr &item : e.items)
+                    improve(best, shortest(item));
+                break;
+            case Expr::Sequence:
+                best.found = true;
+                for (const Expr &item : e.items)
+                    best = concat(best, shortest(item));
+                break;
+            case Expr::Option:
+            case Expr::Repetition:
+                best.found = true;
+                break;
+        }
+        return best;
+    }
+
+    Best starting(const Expr &e, const std::string &terminal)
+    {
+        Best best;
+        switch (e.type) {
+            case Expr::Terminal:
+                if (e.name == terminal)
+                    best = shortest(e);
+                break;
+            case Expr::Nonterminal:
+                best = _starting[e.name][terminal];
+                break;
+            case Expr::Alternation:
+                for (const Expr &item : e.items)
+                    improve(best, starting(item, terminal));
+                break;
+            case Expr::Sequence:
+                // Item i can start the sentence when every item before it
+                // can be empty
+                for (size_t i = 0; i < e.items.size(); ++i) {
+                    Best candidate = starting(e.items[i], terminal);
+                    for (size_t j = i + 1; j < e.items.size(); ++j)
+                        candidate = concat(candidate, shortest(e.items[j]));
+                    improve(best, candidate);
+
+                    Best empty = shortest(e.items[i]);
+                    if (!empty.found || !empty.sentence.empty())
+                        break;
+                }
+                break;
+            case Expr::Option:
+            case Expr::Repetition:
+                best = starting(e.items[0], terminal);
+                break;
+        }
+        return best;
+    }
+
+    const std::map<std::string, Expr> &_rules;
+    std::set<std::string> _terminals;
+    std::map<std::string, Best> _shortest;
+    std::map<std::string, std::map<std::string, Best>> _starting;
+};
+
+// How each grammar terminal is lexed, and a spelling for it
+struct Terminal
+{
+    const char *name;
+    Tokens kind;
+    const char *text;
+};
+
+static const Terminal terminals[] = {
+    {"IMPORT", IMPORT, "import"},
+    {"DEF", DEF, "def"},
+    {"VAR", VAR, "var"},
+    {"IF", IF, "if"},
+    {"ELSE", ELSE, "else"},
+    {"WHILE", WHILE, "while"},
+    {"RETURN", RETURN, "return"},
+    {"USER_FUNCTION_IDENTIFIER", USER_FUNCTION_IDENTIFIER, "@f"},
+    {"IDENTIFIER", IDENTIFIER, "print"},
+    {"VARIABLE_IDENTIFIER", VARIABLE_IDENTIFIER, "a`1"},
+    {"STRING", STRING, "\"s\""},
+    {"REAL", REAL, "1.5"},
+    {"INTEGER", INTEGER, "1"},
+    {"BOOLEAN", BOOLEAN, "true"},
+    {"T", T, ";"},
+    {"EQ", EQ, "="},
+    {"'='", EQ, "="},
+    {"'('", OPEN_PAREN, "("},
+    {"')'", CLOSE_PAREN, ")"},
+    {"'{'", OPEN_BRACE, "{"},
+    {"'}'", CLOSE_BRACE, "}"},
+    {"','", COMMA, ","},
+    {"AND", AND, "&"},
+    {"OR", OR, "|"},
+    {"ANDAND", ANDAND, "&&"},
+    {"OROR", OROR, "||"},
+    {"XOR", XOR, "^"},
+    {"GT", GT, ">"},
+    {"LT", LT, "<"},
+    {"ADD", ADD, "+"},
+    {"SUB", SUB, "-"},
+    {"MUL", MUL, "*"},
+    {"DIV", DIV, "/"},
+    {"MOD", MOD, "%"},
+    {"GE", GE, ">="},
+    {"LE", LE, "<="},
+    {"EE", EE, "=="},
+    {"NE", NE, "!="},
+};
+
+static const Terminal *find_terminal(const std::string &name)
+{
+    for (const Terminal &terminal : terminals) {
+        if (name == terminal.name)
+            return &terminal;
+    }
+    return nullptr;
+}
+
+// Source text for a token of kind
+static std::string token_text(Tokens kind)
+{
+    for (const Terminal &terminal : terminals) {
+        if (terminal.kind == kind)
+            return terminal.text;
+    }
+    return AnnaToken::spelling(kind);
+}
+
+// Owns the source, which the parser only borrows
+struct TestSource
+{
+    std::string text;
+};
+
+// Gives the test access to the rules the parser dispatches by FIRST set
+class TestParser : private TestSource, public AnnaParser
+{
+public:
+    explicit TestParser(const std::string &source)
+        : TestSource{source}, AnnaParser(text.data(), text.size(), "first.anna", "first.anna")
+    {
+        _arena = std::make_shared<NodeArena>();
+        _tokens.setArena(_arena.get());
+    }
+
+    bool atEnd() { return peekToken() == END; }
+
+    using AnnaParser::isPossiblePrimaryExpression;
+    using AnnaParser::parsePrimaryExpression;
+    using AnnaParser::parseStatementExpression;
+    using AnnaParser::parseEmbeddedStatement;
+    using AnnaParser::parseStatement;
+};
+
+// The node kind each alternative parses to
+static const std::map<std::string, AnnaNodeKind> alternative_kinds = {
+    {"literal", AnnaNodeKind::Literal},
+    {"parenthesized expression", AnnaNodeKind::ParenthesizedExpression},
+    {"invocation expression", AnnaNodeKind::InvocationExpression},
+    {"simple name", AnnaNodeKind::SimpleName},
+    {"assignment", AnnaNodeKind::Assignment},
+    {"block", AnnaNodeKind::Block},
+    {"empty statement", AnnaNodeKind::EmptyStatement},
+    {"expression statement", AnnaNodeKind::ExpressionStatement},
+    {"iteration statement", AnnaNodeKind::WhileStatement},
+    {"selection statement", AnnaNodeKind::IfStatement},
+    {"return statement", AnnaNodeKind::ReturnStatement},
+    {"variable declaration statement", AnnaNodeKind::VariableDeclarationStatement},
+};
+
+// Parses text with the dispatching rule and returns the kind of node the
+// alternative it took produced; false if nothing was parsed
+static bool parse_with(const std::string &rule, const std::string &text, AnnaNodeKind &kind, bool &atEnd)
+{
+    TestParser parser(text);
+    AnnaSyntax *node = nullptr;
+
+    if (rule == "primary expression") {
+        node = parser.parsePrimaryExpression();
+    } else if (rule == "statement expression") {
+        gcnStatementExpression expr = parser.parseStatementExpression();
+        if (expr) {
+            // The wrapper holds the alternative
+            if (expr->isAssignment)
+                node = expr->assignment_opt;
+            else
+                node = expr->invocationExpression_opt;
+        }
+    } else if (rule == "embedded statement") {
+        node = parser.parseEmbeddedStatement();
+    } else if (rule == "statement") {
+        node = parser.parseStatement();
+    }
+
+    if (!node)
+        return false;
+    kind = node->kind();
+    atEnd = parser.atEnd();
+    return true;
+}
+
+static std::string spell(const Sentences::Sentence &sentence)
+{
+    std::string text;
+    for (const std::string &name : sentence) {
+        const Terminal *terminal = find_terminal(name);
+        text += terminal ? terminal->text : "?" + name + "?";
+        text += ' ';
+    }
+    return text + "\n";
+}
+
+// The node kind a sentence of rule starting with terminal parses to
+static bool expected_kind(std::map<std::string, Expr> &rules, Sentences &sentences,
+                          const std::string &rule, const std::string &terminal, AnnaNodeKind &kind)
+{
+    for (const Expr &alt : rules[rule].items) {
+        if (!sentences.first(alt.name).count(terminal))
+            continue;
+        auto it = alternative_kinds.find(alt.name);
+        if (it != alternative_kinds.end()) {
+            kind = it->second;
+            return true;
+        }
+        return expected_kind(rules, sentences, alt.name, terminal, kind);
+    }
+    return false;
+}
+
+static void check_dispatch(std::map<std::string, Expr> &rules, Sentences &sentences, const std::string &rule)
+{
+    const Expr &body = rules[rule];
+    if (!CHECK_MSG(body.type == Expr::Alternation, rule + " is an alternation of rules"))
+        return;
+
+    // One token can only pick an alternative when the FIRST sets are disjoint
+    std::set<std::string> seen;
+    for (const Expr &alt : body.items) {
+        CHECK_MSG(alt.type == Expr::Nonterminal, rule + ": alternative is a rule");
+        for (const std::string &terminal : sentences.first(alt.name))
+            CHECK_MSG(seen.insert(terminal).second, rule + ": " + terminal + " starts more than one alternative");
+    }
+
+    for (const Expr &alt : body.items) {
+        for (const std::string &terminal : sentences.first(alt.name)) {
+            const Terminal *lexed = find_terminal(terminal);
+            if (!CHECK_MSG(lexed, "a spelling for " + terminal))
+                continue;
+
+            std::string text = spell(sentences.startingWith(alt.name, terminal));
+            AnnaNodeKind expected = AnnaNodeKind::Error;
+            AnnaNodeKind kind = AnnaNodeKind::Error;
+            bool atEnd = false;
+            CHECK_MSG(expected_kind(rules, sentences, rule, terminal, expected), rule + ": kind for " + alt.name);
+            if (CHECK_MSG(parse_with(rule, text, kind, atEnd), rule + " parses `" + text + "'")) {
+                CHECK_MSG(kind == expected, rule + ": `" + text + "' is parsed as " + alt.name);
+                CHECK_MSG(atEnd, rule + ": `" + text + "' is parsed whole");
+            }
+        }
+    }
+
+    // Tokens outside the FIRST set of the rule do not start it
+    std::set<std::string> first = sentences.first(rule);
+    for (int k = DEF; k <= COMMA; ++k) {
+        Tokens kind = static_cast<Tokens>(k);
+        bool inFirst = false;
+        for (const std::string &terminal : first)
+            inFirst = inFirst || find_terminal(terminal)->kind == kind;
+        if (inFirst)
+            continue;
+
+        std::string text = token_text(kind) + "\n";
+        AnnaNodeKind parsed;
+        bool atEnd;
+        CHECK_MSG(!parse_with(rule, text, parsed, atEnd), rule + " does not start with `" + token_text(kind) + "'");
+    }
+}
+
+int main()
+{
+    std::ifstream in(ANNA_EBNF);
+    if (!CHECK_MSG(in.good(), std::string("cannot open ") + ANNA_EBNF))
+        return test_result();
+    std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    std::map<std::string, Expr> rules = GrammarReader(text).read();
+    Sentences sentences(rules);
+
+    for (const std::string &terminal : sentences.terminals())
+        CHECK_MSG(find_terminal(terminal), "a spelling for " + terminal);
+
+    // isPossiblePrimaryExpression() is exactly FIRST(primary expression)
+    std::set<std::string> primary = sentences.first("primary expression");
+    for (int k = DEF; k <= COMMA; ++k) {
+        Tokens kind = static_cast<Tokens>(k);
+        bool inFirst = false;
+        for (const std::string &terminal : primary)
+            inFirst = inFirst || find_terminal(terminal)->kind == kind;
+
+        TestParser parser(token_text(kind) + "\n");
+        CHECK_MSG(parser.isPossiblePrimaryExpression() == inFirst,
+                  "isPossiblePrimaryExpression() for `" + token_text(kind) + "'");
+    }
+
+    check_dispatch(rules, sentences, "primary expression");
+    check_dispatch(rules, sentences, "statement expression");
+    check_dispatch(rules, sentences, "embedded statement");
+    check_dispatch(rules, sentences, "statement");
+
+    return test_result();
+}
@@ -0,0 +1,154 @@
+/**************************************************************************
+ * Copyright (c) 2015 Afa.L Cheng <afa@afa.moe>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ***************************************************************************/
+
+// Checks the layout of FlatSyntaxTree, and that ExportedSymbolScanner
+// collects the same symbols as ExportedSymbolVisitor.
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "parser.h"
+#include "exportedsymbolvisitor.h"
+#include "exportedsymbolscanner.h"
+#include "testing.h"
+
+struct Source
+{
+    const char *text;
+    bool errors;
+};
+
+static const Source sources[] = {
+    // Declarations interleaved, functions with zero, one and three parameters
+    {"import io\n"
+    "var a`1 = 1\n"
+    "def @f()\n"
+    "{\n"
+    "    return 1\n"
+    "}\n"
+    "var a`2\n"
+    "def @g(a`1)\n"
+    "{\n"
+    "    print(a`1)\n"
+    "}\n"
+    "def @h(a`1, a`2, a`3)\n"
+    "{\n"
+    "    return a`1 + a`2\n"
+    "}\n"
+    "var 50USD = \"s\"\n", false},
+
+    // Top-level errors between declarations
+    {"var a`1 = 1\n"
+    "+ + +\n"
+    "def @f(a`1, a`2)\n"
+    "{\n"
+    "    return a`1\n"
+    "}\n"
+    ") (\n"
+    "var a`2 = (1)\n", true},
+
+    // Nothing but an import
+    {"import io\n", false},
+};
+
+// Preorder, contiguous children and subtree ends, and the rows agree
+// with the nodes they stand for
+static void check_layout(const FlatSyntaxTree &tree, const std::string &name)
+{
+    typedef FlatSyntaxTree::Index Index;
+
+    CHECK_MSG(tree.root() == 0, name + ": root is node 0");
+    CHECK_MSG(tree.parent(tree.root()) == FlatSyntaxTree::None, name + ": root has no parent");
+    CHECK_MSG(tree.end(tree.root()) == tree.size(), name + ": root spans the tree");
+
+    for (Index i = 0; i < tree.size(); ++i) {
+        const std::string at = name + ": node " + std::to_string(i);
+
+        CHECK_MSG(tree.kind(i) == tree.node(i).kind(), at + ": kind");
+        CHECK_MSG(tree.isToken(i) == (tree.kind(i) >= AnnaNodeKind::Token), at + ": token row");
+        if (tree.isToken(i)) {
+            AnnaToken &token = static_cast<AnnaToken &>(tree.node(i));
+            CHECK_MSG(tree.childCount(i) == 0, at + ": token has no children");
+            CHECK_MSG(tree.token(i) == token.token() && tree.row(i) == token.row()
+                      && tree.col(i) == token.col() && &tree.text(i) == &token.text(), at + ": token data");
+        }
+
+        Index next = i + 1;
+        for (const Index *c = tree.childrenBegin(i); c != tree.childrenEnd(i); ++c) {
+            CHECK_MSG(*c == next && tree.parent(*c) == i, at + ": child in preorder");
+            next = tree.end(*c);
+        }
+        CHECK_MSG(next == tree.end(i), at + ": end after the last child");
+    }
+}
+
+static void check_symbols(gcnCompilationUnit unit, const FlatSyntaxTree &tree, const std::string &name)
+{
+    ExportedSymbolVisitor visitor;
+    unit->Accept(visitor);
+    CompilationUnitSymbolCollection visited = visitor.symbols();
+
+    ExportedSymbolScanner scanner(tree);
+    CompilationUnitSymbolCollection scanned = scanner.symbols();
+
+    CHECK_MSG(scanned.exportSymbols() == visited.exportSymbols(), name + ": same exported symbols");
+    CHECK_MSG(scanned.compilationUnitName == visited.compilationUnitName, name + ": same unit name");
+    CHECK_MSG(scanned.globals.size() == visited.globals.size()
+              && scanned.functions.size() == visited.functions.size(), name + ": same symbol counts");
+}
+
+static void check_source(const std::string &text, bool errors, const std::string &name)
+{
+    AnnaParser parser(text.data(), text.size(), name, name);
+    gcnCompilationUnit unit = parser.parse();
+    if (!CHECK_MSG(unit != nullptr, name + ": parsed"))
+        return;
+    CHECK_MSG(parser.hasErrors() == errors, name + (errors ? ": has errors" : ": has no errors"));
+
+    FlatSyntaxTree tree(unit);
+    check_layout(tree, name);
+    check_symbols(unit, tree, name);
+}
+
+int main()
+{
+    int n = 0;
+    for (const Source &source : sources)
+        check_source(source.text, source.errors, "source" + std::to_string(n++));
+
+    std::ifstream sample(ANNA_SAMPLE, std::ios::binary);
+    if (CHECK_MSG(sample.good(), ANNA_SAMPLE)) {
+        std::stringstream text;
+        text << sample.rdbuf();
+        check_source(text.str(), false, "sample.anna");
+    }
+
+    FlatSyntaxTree empty(nullptr);
+    CHECK(empty.size() == 0);
+    CHECK(empty.root() == FlatSyntaxTree::None);
+    CHECK(ExportedSymbolScanner(empty).symbols().globals.empty());
+
+    return test_result();
+}
@@ -0,0 +1,152 @@
+/**************************************************************************
+ * Copyright (c) 2015 Afa.L Cheng <afa@afa.moe>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ***************************************************************************/
+
+// Checks that parsing definitions on worker threads gives the same tree
+// and diagnostics as parsing serially, and that jobs the parser has gone
+// past are not handed to workers.
+
+#include <string>
+
+#include "parser.h"
+#include "testing.h"
+
+static std::string nested(int depth)
+{
+    return std::string(depth, '(') + "1" + std::string(depth, ')');
+}
+
+// Definitions of every shape, with errors and deep nesting among them
+static std::string sample_source()
+{
+    std::string text = "import io\n"
+                       "var a`1 = 1\n\n";
+    for (int i = 0; i < 60; ++i) {
+        std::string n = std::to_string(i);
+        text += "-_- definition " + n + " >_<\n";
+        text += "def @f" + n + "(a`1, a`2)\n{\n";
+        switch (i % 6) {
+            case 0:
+                text += "    var a`3 = a`1\n    a`3 = a`1 + a`2 * " + n + "\n    return a`3\n";
+                break;
+            case 1:
+                text += "    while (a`1 < " + n + ") {\n        a`1 = a`1 + 1\n    }\n    print(a`1, \"s\")\n";
+                break;
+            case 2:
+                // A syntax error the definition recovers from
+                text += "    var = 1\n    if (a`1 > a`2) {\n        return a`1\n    } else {\n        return a`2\n    }\n";
+                break;
+            case 3:
+                // Deeper than a worker parses, within the parser's limit
+                text += "    a`1 = " + nested(300) + "\n";
+                break;
+            case 4:
+                // Deeper than the parser's limit
+                text += "    a`1 = " + nested(450) + "\n";
+                break;
+            default:
+                text += "    @f0(" + n + ", true)\n    ;\n";
+                break;
+        }
+        text += "}\n\n";
+        if (i % 10 == 9)
+            text += "var a`9" + n + " = " + n + "\n";
+    }
+    // Not closed, so the workers cannot take it
+    text += "def @g()\n{\n    return 1\n";
+    return text;
+}
+
+static void check_same(const std::string &text, bool memoize)
+{
+    AnnaParser serial(text.data(), text.size(), "parallel.anna", "parallel");
+    serial.setMemoization(memoize);
+    serial.setMaxDepth(400);
+    gcnCompilationUnit serialUnit = serial.parse();
+    bool serialHasErrors = serial.hasErrors();
+
+    AnnaParser parallel(text.data(), text.size(), "parallel.anna", "parallel");
+    parallel.setMemoization(memoize);
+    parallel.setMaxDepth(400);
+    parallel.setParallel(true);
+    gcnCompilationUnit parallelUnit = parallel.parse();
+
+    CHECK(serialUnit != nullptr);
+    CHECK(parallelUnit != nullptr);
+    CHECK(dump_tree(parallelUnit) == dump_tree(serialUnit));
+    CHECK(parallel.hasErrors() == serialHasErrors);
+    CHECK(printed_errors(parallel) == printed_errors(serial));
+}
+
+// Reaches into the job queues, to move the parser past queued jobs as a
+// serial parse running over their `def' would
+class JobParser : public AnnaParser
+{
+public:
+    explicit JobParser(const std::string &text)
+        : AnnaParser(text.data(), text.size(), "parallel.anna", "parallel")
+    {
+        _arena = std::make_shared<NodeArena>();
+        _tokens.setArena(_arena.get());
+        setParallel(true);
+    }
+
+    // Queues jobs that no worker starts, then moves to the `def' after
+    // them. None of them may be left for a worker.
+    void skipQueuedJobs()
+    {
+        // Workers return as soon as they wake
+        {
+            std::lock_guard<std::mutex> lock(_definitionMutex);
+            _closingDefinitionJobs = true;
+        }
+        queueDefinitionJobs(0);
+        if (!CHECK(!_definitionJobs.empty()))
+            return;
+
+        size_t next = _definitionJobs.back()->end;
+        while (bufferToken(next) && _tokens.kind(next) != DEF)
+            ++next;
+        currentTokenIdx = next;
+        std::vector<gcnToken> tokens;
+        CHECK(takeDefinitionJob(tokens) == nullptr);
+        CHECK(_definitionJobs.empty());
+
+        std::lock_guard<std::mutex> lock(_definitionMutex);
+        CHECK_MSG(_unstartedDefinitionJobs.empty(), "jobs the parser is past are not left for a worker");
+    }
+};
+
+int main()
+{
+    std::string text = sample_source();
+    check_same(text, false);
+    check_same(text, true);
+
+    std::string definitions;
+    for (int i = 0; i < 64; ++i)
+        definitions += "def @f" + std::to_string(i) + "()\n{\n    return 1\n}\n";
+    JobParser(definitions).skipQueuedJobs();
+
+    return test_result();
+}
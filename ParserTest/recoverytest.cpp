@@ -0,0 +1,223 @@
+/**************************************************************************
+ * Copyright (c) 2015 Afa.L Cheng <afa@afa.moe>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ***************************************************************************/
+
+// Checks panic-mode recovery: where a failed declaration or statement
+// resumes, the error nodes left in its place and the diagnostics kept.
+
+#include <string>
+
+#include "parser.h"
+#include "testing.h"
+
+// The kinds of the nodes, by the names of their rules
+static std::string kinds(const std::vector<AnnaSyntax *> &nodes)
+{
+    std::string names;
+    for (AnnaSyntax *node : nodes) {
+        if (!names.empty())
+            names += ' ';
+        switch (node->kind()) {
+            case AnnaNodeKind::ImportDirective:
+                names += "import";
+                break;
+            case AnnaNodeKind::VariableDeclarationStatement:
+                names += "var";
+                break;
+            case AnnaNodeKind::FunctionDefinition:
+                names += "def";
+                break;
+            case AnnaNodeKind::ExpressionStatement:
+                names += "expression";
+                break;
+            case AnnaNodeKind::ReturnStatement:
+                names += "return";
+                break;
+            case AnnaNodeKind::EmptyStatement:
+                names += "empty";
+                break;
+            case AnnaNodeKind::Block:
+                names += "block";
+                break;
+            case AnnaNodeKind::Error:
+                names += "error";
+                break;
+            default:
+                names += "other";
+                break;
+        }
+    }
+    return names;
+}
+
+static std::string kinds(const std::vector<gcnStatement> &statements)
+{
+    return kinds(std::vector<AnnaSyntax *>(statements.begin(), statements.end()));
+}
+
+// The tokens an error node skipped, separated by blanks
+static std::string skipped(AnnaSyntax *node)
+{
+    std::string text;
+    if (node->kind() != AnnaNodeKind::Error)
+        return text;
+
+    for (gcnToken token : static_cast<AnnaErrorSyntax *>(node)->tokens) {
+        if (!text.empty())
+            text += ' ';
+        text += token->text() == "\n" ? "\\n" : token->text();
+    }
+    return text;
+}
+
+// Statements of the body of the nth function definition
+static std::vector<gcnStatement> body(gcnCompilationUnit unit, size_t n)
+{
+    if (!unit || n >= unit->functionDefinitions.size())
+        return std::vector<gcnStatement>();
+    return unit->functionDefinitions[n]->functionBody->block->statements;
+}
+
+struct Parse
+{
+    explicit Parse(const std::string &source)
+        : text(source), parser(text.data(), text.size(), "recovery.anna", "recovery")
+    {
+        unit = parser.parse();
+        hasErrors = parser.hasErrors();
+        errors = printed_errors(parser);
+    }
+
+    std::string text;
+    AnnaParser parser;
+    gcnCompilationUnit unit;
+    bool hasErrors;
+    std::string errors;
+};
+
+static size_t count(const std::string &text, const std::string &what)
+{
+    size_t n = 0;
+    for (size_t i = text.find(what); i != std::string::npos; i = text.find(what, i + 1))
+        ++n;
+    return n;
+}
+
+int main()
+{
+    {
+        // A top-level error resumes after the end of its statement, and
+        // keeps its place among the declarations
+        Parse p("import io\n"
+                "+ + +\n"
+                "var a`1 = 1\n");
+        if (CHECK(p.unit != nullptr)) {
+            CHECK(kinds(p.unit->declarations) == "import error var");
+            CHECK(skipped(p.unit->declarations[1]) == "+ + + \\n");
+            CHECK(p.unit->errors.size() == 1);
+        }
+        CHECK(p.hasErrors);
+        CHECK(count(p.errors, "expected declaration") == 1);
+    }
+
+    {
+        // Braces are skipped whole; `def' ends the skip
+        Parse p("var a`1 = 1\n"
+                "} ) { a`1 ; }\n"
+                "+ def @f()\n{\n    return 1\n}\n");
+        if (CHECK(p.unit != nullptr)) {
+            CHECK(kinds(p.unit->declarations) == "var error error def");
+            CHECK(skipped(p.unit->declarations[1]) == "} ) { a`1 ; } \\n");
+            CHECK(skipped(p.unit->declarations[2]) == "+");
+            CHECK(kinds(body(p.unit, 0)) == "return");
+        }
+        CHECK(p.hasErrors);
+    }
+
+    {
+        // A failed statement resumes at the next statement, at `var', or
+        // at the `}' closing its block
+        Parse p("def @f(a`1)\n{\n"
+                "    var = 1\n"
+                "    + + var a`2 = 2\n"
+                "    a`1 = (1\n"
+                "    { a`1 ) }\n"
+                "    return a`1\n"
+                "    ) ) }\n");
+        std::vector<gcnStatement> statements = body(p.unit, 0);
+        if (CHECK(kinds(statements) == "empty error error var error block return error")) {
+            CHECK(skipped(statements[1]) == "var = 1 \\n");
+            CHECK(skipped(statements[2]) == "+ +");
+            CHECK(skipped(statements[4]) == "a`1 = ( 1 \\n");
+            CHECK(skipped(statements[7]) == ") )");
+
+            std::vector<gcnStatement> inner = static_cast<AnnaBlockSyntax *>(statements[5])->statements;
+            if (CHECK(kinds(inner) == "error"))
+                CHECK(skipped(inner[0]) == "a`1 )");
+        }
+        CHECK(p.hasErrors);
+        // One diagnostic per error node, from the alternative that got
+        // furthest
+        CHECK(count(p.errors, "error:") == 5);
+        CHECK(count(p.errors, "expected `(' in parseParenthesizedExpression") == 1);
+        CHECK(count(p.errors, "expected statement in parseBlock") == 2);
+    }
+
+    {
+        // A block missing its `}' fails its definition. Recovery skips to
+        // the next `def', which parses.
+        Parse p("def @f()\n{\n    return 1\n"
+                "def @g()\n{\n    return 2\n}\n");
+        if (CHECK(p.unit != nullptr && kinds(p.unit->declarations) == "error error def")) {
+            CHECK(skipped(p.unit->declarations[0]) == "def @f ( ) \\n");
+            CHECK(skipped(p.unit->declarations[1]) == "{ \\n return 1 \\n");
+            CHECK(kinds(body(p.unit, 0)) == "return");
+        }
+        CHECK(count(p.errors, "expected `}' in parseBlock") == 1);
+        CHECK(p.hasErrors);
+    }
+
+    {
+        // The lexer stops at a character it does not know; that is an
+        // error even though the tokens before it parse
+        Parse p("var a`1 = 1\n$\n");
+        if (CHECK(p.unit != nullptr))
+            CHECK(kinds(p.unit->declarations) == "var");
+        CHECK(p.hasErrors);
+    }
+
+    {
+        Parse p("import io\nvar a`1 = 1\n");
+        CHECK(!p.hasErrors);
+        CHECK(p.errors.empty());
+    }
+
+    {
+        // A missing file
+        AnnaParser parser(std::string("/nonexistent/recovery.anna"), "recovery");
+        CHECK(parser.parse() == nullptr);
+        CHECK(parser.hasErrors());
+    }
+
+    return test_result();
+}
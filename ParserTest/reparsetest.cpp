@@ -0,0 +1,187 @@
+/**************************************************************************
+ * Copyright (c) 2015 Afa.L Cheng <afa@afa.moe>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ***************************************************************************/
+
+// Checks reparse() against parsing the edited source from scratch, for
+// edits before, inside and after declarations, with the parser that
+// reparses in each of its modes.
+
+#include <string>
+
+#include "parser.h"
+#include "testing.h"
+
+static const std::string source =
+        "import io\n"
+        "var a`1 = 1\n"
+        "\n"
+        "-_- f >_<\n"
+        "def @f(a`1)\n"
+        "{\n"
+        "    return a`1 + 1\n"
+        "}\n"
+        "\n"
+        "var a`2 = 50US\n"
+        "def @g()\n"
+        "{\n"
+        "    print(\"s\")\n"
+        "}\n";
+
+struct Mode
+{
+    const char *name;
+    bool parallel;
+    bool memoize;
+};
+
+static const Mode modes[] = {
+    {"serial", false, false},
+    {"memo", false, true},
+    {"parallel", true, false},
+    {"parallel memo", true, true},
+};
+
+struct Edit
+{
+    const char *name;
+    size_t offset;
+    size_t removed;
+    const char *inserted;
+};
+
+// The offset just after the first occurrence of what
+static size_t after(const std::string &text, const std::string &what)
+{
+    return text.find(what) + what.size();
+}
+
+static void configure(AnnaParser &parser, const Mode &mode)
+{
+    parser.setParallel(mode.parallel);
+    parser.setMemoization(mode.memoize);
+}
+
+// Compares a reparse of text after edit with a serial parse from scratch
+static void check_edit(AnnaParser &parser, gcnCompilationUnit &tree, std::string &text, const Edit &edit,
+                       const Mode &mode)
+{
+    const std::string name = std::string(mode.name) + ": " + edit.name;
+    std::string before = dump_tree(tree);
+
+    text.replace(edit.offset, edit.removed, edit.inserted);
+    gcnCompilationUnit reparsed = parser.reparse(tree, edit.offset, edit.removed, edit.inserted);
+
+    AnnaParser full(text.data(), text.size(), "reparse.anna", "reparse");
+    gcnCompilationUnit parsed = full.parse();
+
+    CHECK_MSG(dump_tree(reparsed) == dump_tree(parsed), name + ": same tree");
+    CHECK_MSG(parser.hasErrors() == full.hasErrors(), name + ": same errors");
+    CHECK_MSG(printed_errors(parser) == printed_errors(full), name + ": same diagnostics");
+    CHECK_MSG(dump_tree(tree) == before, name + ": previous tree unchanged");
+
+    tree = reparsed;
+}
+
+int main()
+{
+    const Edit edits[] = {
+        {"insert a line before everything", 0, 0, "var a`9 = 9\n"},
+        {"indent the first declaration", 0, 0, "  "},
+        {"change an operand", after(source, "a`1 + "), 1, "2"},
+        {"add a statement", after(source, "a`1 + 1"), 0, "\n    a`1 = 2"},
+        {"open a comment", after(source, "-_- f "), 0, "-_- "},
+        {"close the body early", after(source, "return a`1 + 1\n"), 0, "}\n"},
+        {"drop a brace", source.find("}\n\nvar"), 1, ""},
+        {"complete 50USD", after(source, "50US"), 0, "D"},
+        {"insert between declarations", after(source, "}\n\n"), 0, "import os\n\n"},
+        {"append", source.size(), 0, "var a`3 = 3\n"},
+        {"break the last line", source.size() - 2, 0, "@"},
+        {"remove everything", 0, source.size(), ""},
+    };
+
+    for (const Mode &mode : modes) {
+        // Each edit on its own
+        for (const Edit &edit : edits) {
+            std::string text = source;
+            AnnaParser parser(source.data(), source.size(), "reparse.anna", "reparse");
+            configure(parser, mode);
+            gcnCompilationUnit tree = parser.parse();
+            check_edit(parser, tree, text, edit, mode);
+        }
+
+        // A run of edits, each on the tree of the one before
+        {
+            std::string text = source;
+            AnnaParser parser(source.data(), source.size(), "reparse.anna", "reparse");
+            configure(parser, mode);
+            gcnCompilationUnit tree = parser.parse();
+            check_edit(parser, tree, text, Edit{"run: insert a line", 0, 0, "\n"}, mode);
+            check_edit(parser, tree, text, Edit{"run: change an operand", after(text, "a`1 + "), 1, "3"}, mode);
+            check_edit(parser, tree, text, Edit{"run: add a definition", after(text, "}\n\n"), 0, "def @h()\n{\n}\n"}, mode);
+            check_edit(parser, tree, text, Edit{"run: complete 50USD", after(text, "50US"), 0, "D"}, mode);
+            check_edit(parser, tree, text, Edit{"run: remove a line", 0, 1, ""}, mode);
+        }
+
+        // Declarations before an edit are kept as they are, and those after
+        // it are carried over
+        {
+            std::string text = source;
+            AnnaParser parser(source.data(), source.size(), "reparse.anna", "reparse");
+            configure(parser, mode);
+            gcnCompilationUnit tree = parser.parse();
+            gcnCompilationUnit previous = tree;
+            check_edit(parser, tree, text, Edit{"edit @f", after(source, "a`1 + "), 1, "2"}, mode);
+            if (CHECK_MSG(previous->declarations.size() == 5 && tree->declarations.size() == 5,
+                          std::string(mode.name) + ": five declarations")) {
+                CHECK_MSG(tree->declarations[0] == previous->declarations[0], std::string(mode.name) + ": import kept");
+                CHECK_MSG(tree->declarations[1] == previous->declarations[1], std::string(mode.name) + ": var kept");
+                CHECK_MSG(tree->declarations[2] != previous->declarations[2], std::string(mode.name) + ": @f parsed again");
+                CHECK_MSG(tree->declarations[4] == previous->declarations[4], std::string(mode.name) + ": @g carried over");
+            }
+        }
+
+        // An edit past the end is refused and leaves the parser as it was;
+        // one that removes past the end is cut short
+        {
+            const std::string name = mode.name;
+            std::string text = source;
+            AnnaParser parser(source.data(), source.size(), "reparse.anna", "reparse");
+            configure(parser, mode);
+            gcnCompilationUnit tree = parser.parse();
+            std::string before = dump_tree(tree);
+
+            CHECK_MSG(parser.reparse(tree, source.size() + 1, 0, "x") == nullptr, name + ": edit past the end refused");
+            CHECK_MSG(parser.hasErrors(), name + ": refused edit reported");
+            CHECK_MSG(dump_tree(tree) == before, name + ": refused edit leaves the tree");
+
+            check_edit(parser, tree, text, Edit{"after a refused edit", after(source, "a`1 + "), 1, "2"}, mode);
+            CHECK_MSG(!parser.hasErrors(), name + ": next edit clears the report");
+
+            gcnCompilationUnit cut = parser.reparse(tree, text.size() - 2, 1000, "");
+            AnnaParser full(text.data(), text.size() - 2, "reparse.anna", "reparse");
+            CHECK_MSG(dump_tree(cut) == dump_tree(full.parse()), name + ": removed cut short at the end");
+        }
+    }
+
+    return test_result();
+}
@@ -0,0 +1,225 @@
+/**************************************************************************
+ * Copyright (c) 2015 Afa.L Cheng <afa@afa.moe>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ***************************************************************************/
+
+// Checks that AnnaSwitchVisitor reaches the same visit function for every
+// node as Accept() does on an AnnaSyntaxVisitor, by counting the nodes of
+// each kind both ways.
+
+#include <array>
+#include <string>
+
+#include "annaswitchvisitor.h"
+#include "flatsyntaxtree.h"
+#include "parser.h"
+#include "testing.h"
+
+static const size_t KindCount = static_cast<size_t>(AnnaNodeKind::StringToken) + 1;
+typedef std::array<int, KindCount> KindCounts;
+
+// Between them, the sources hold a node of every kind
+static const char *const sources[] = {
+    "import io\n"
+    "var a`1 = 1.5\n"
+    "var a`2 = true\n"
+    "def @f(a`1, a`2)\n"
+    "{\n"
+    "    if (a`1 < (a`2 + 2)) {\n"
+    "        a`1 = @f(a`1, \"s\")\n"
+    "    } else\n"
+    "        print\n"
+    "    while (false)\n"
+    "        return a`1\n"
+    "    return\n"
+    "}\n",
+
+    "var a`1 = 1\n"
+    "+ + +\n"
+    "def @g()\n"
+    "{\n"
+    "    ) a`1\n"
+    "}\n",
+};
+
+// Counts by the concrete class of the overload that Accept() picks
+class AcceptCounter : public AnnaSyntaxVisitor
+{
+public:
+    explicit AcceptCounter(KindCounts &counts) : _counts(counts) {}
+
+    void Visit(AnnaEOSSyntax &) { count(AnnaNodeKind::EOS); }
+    void Visit(AnnaCompilationUnitSyntax &) { count(AnnaNodeKind::CompilationUnit); }
+    void Visit(AnnaImportDirectiveSyntax &) { count(AnnaNodeKind::ImportDirective); }
+    void Visit(AnnaFunctionIdentifierSyntax &) { count(AnnaNodeKind::FunctionIdentifier); }
+    void Visit(AnnaExpressionSyntax &) { abstract(); }
+    void Visit(AnnaBinaryOperationExpressionSyntax &) { count(AnnaNodeKind::BinaryOperationExpression); }
+    void Visit(AnnaUnaryExpressionSyntax &) { abstract(); }
+    void Visit(AnnaPrimaryExpressionSyntax &) { abstract(); }
+    void Visit(AnnaSimpleNameSyntax &) { count(AnnaNodeKind::SimpleName); }
+    void Visit(AnnaLiteralSyntax &) { count(AnnaNodeKind::Literal); }
+    void Visit(AnnaParenthesizedExpressionSyntax &) { count(AnnaNodeKind::ParenthesizedExpression); }
+    void Visit(AnnaBinaryOperatorSyntax &) { count(AnnaNodeKind::BinaryOperator); }
+    void Visit(AnnaInvocationExpressionSyntax &) { count(AnnaNodeKind::InvocationExpression); }
+    void Visit(AnnaArgumentListSyntax &) { count(AnnaNodeKind::ArgumentList); }
+    void Visit(AnnaFunctionDefinitionSyntax &) { count(AnnaNodeKind::FunctionDefinition); }
+    void Visit(AnnaFunctionHeaderSyntax &) { count(AnnaNodeKind::FunctionHeader); }
+    void Visit(AnnaFormalParameterListSyntax &) { count(AnnaNodeKind::FormalParameterList); }
+    void Visit(AnnaFunctionBodySyntax &) { count(AnnaNodeKind::FunctionBody); }
+    void Visit(AnnaBlockSyntax &) { count(AnnaNodeKind::Block); }
+    void Visit(AnnaStatementSyntax &) { abstract(); }
+    void Visit(AnnaEmbeddedStatementSyntax &) { abstract(); }
+    void Visit(AnnaVariableDeclarationStatementSyntax &) { count(AnnaNodeKind::VariableDeclarationStatement); }
+    void Visit(AnnaEmptyStatementSyntax &) { count(AnnaNodeKind::EmptyStatement); }
+    void Visit(AnnaExpressionStatementSyntax &) { count(AnnaNodeKind::ExpressionStatement); }
+    void Visit(AnnaStatementExpressionSyntax &) { count(AnnaNodeKind::StatementExpression); }
+    void Visit(AnnaSelectionStatementSyntax &) { abstract(); }
+    void Visit(AnnaIfStatementSyntax &) { count(AnnaNodeKind::IfStatement); }
+    void Visit(AnnaIterationStatementSyntax &) { abstract(); }
+    void Visit(AnnaWhileStatementSyntax &) { count(AnnaNodeKind::WhileStatement); }
+    void Visit(AnnaAssignmentSyntax &) { count(AnnaNodeKind::Assignment); }
+    void Visit(AnnaFormalParameterSyntax &) { count(AnnaNodeKind::FormalParameter); }
+    void Visit(AnnaReturnStatementSyntax &) { count(AnnaNodeKind::ReturnStatement); }
+    void Visit(AnnaErrorSyntax &) { count(AnnaNodeKind::Error); }
+
+    void Visit(AnnaToken &) { count(AnnaNodeKind::Token); }
+    void Visit(IdentifierToken &) { count(AnnaNodeKind::IdentifierToken); }
+    void Visit(RealToken &) { count(AnnaNodeKind::RealToken); }
+    void Visit(IntegerToken &) { count(AnnaNodeKind::IntegerToken); }
+    void Visit(BooleanToken &) { count(AnnaNodeKind::BooleanToken); }
+    void Visit(StringToken &) { count(AnnaNodeKind::StringToken); }
+    void Visit(LiteralToken &) { abstract(); }
+
+private:
+    void count(AnnaNodeKind kind) { ++_counts[static_cast<size_t>(kind)]; }
+    void abstract() { CHECK_MSG(false, "Accept() reached an abstract class"); }
+
+    KindCounts &_counts;
+};
+
+// Counts by the visit function the switch picks. The result is checked
+// too, so a case that falls through to visitNode() is caught.
+class SwitchCounter : public AnnaSwitchVisitor<SwitchCounter, bool>
+{
+public:
+    explicit SwitchCounter(KindCounts &counts) : _counts(counts) {}
+
+    bool visitNode(AnnaNode &) { return false; }
+
+    bool visitEOS(AnnaEOSSyntax &) { return count(AnnaNodeKind::EOS); }
+    bool visitCompilationUnit(AnnaCompilationUnitSyntax &) { return count(AnnaNodeKind::CompilationUnit); }
+    bool visitImportDirective(AnnaImportDirectiveSyntax &) { return count(AnnaNodeKind::ImportDirective); }
+    bool visitFunctionIdentifier(AnnaFunctionIdentifierSyntax &) { return count(AnnaNodeKind::FunctionIdentifier); }
+    bool visitBinaryOperationExpression(AnnaBinaryOperationExpressionSyntax &) { return count(AnnaNodeKind::BinaryOperationExpression); }
+    bool visitSimpleName(AnnaSimpleNameSyntax &) { return count(AnnaNodeKind::SimpleName); }
+    bool visitLiteral(AnnaLiteralSyntax &) { return count(AnnaNodeKind::Literal); }
+    bool visitParenthesizedExpression(AnnaParenthesizedExpressionSyntax &) { return count(AnnaNodeKind::ParenthesizedExpression); }
+    bool visitBinaryOperator(AnnaBinaryOperatorSyntax &) { return count(AnnaNodeKind::BinaryOperator); }
+    bool visitInvocationExpression(AnnaInvocationExpressionSyntax &) { return count(AnnaNodeKind::InvocationExpression); }
+    bool visitArgumentList(AnnaArgumentListSyntax &) { return count(AnnaNodeKind::ArgumentList); }
+    bool visitFunctionDefinition(AnnaFunctionDefinitionSyntax &) { return count(AnnaNodeKind::FunctionDefinition); }
+    bool visitFunctionHeader(AnnaFunctionHeaderSyntax &) { return count(AnnaNodeKind::FunctionHeader); }
+    bool visitFormalParameterList(AnnaFormalParameterListSyntax &) { return count(AnnaNodeKind::FormalParameterList); }
+    bool visitFunctionBody(AnnaFunctionBodySyntax &) { return count(AnnaNodeKind::FunctionBody); }
+    bool visitBlock(AnnaBlockSyntax &) { return count(AnnaNodeKind::Block); }
+    bool visitVariableDeclarationStatement(AnnaVariableDeclarationStatementSyntax &) { return count(AnnaNodeKind::VariableDeclarationStatement); }
+    bool visitEmptyStatement(AnnaEmptyStatementSyntax &) { return count(AnnaNodeKind::EmptyStatement); }
+    bool visitExpressionStatement(AnnaExpressionStatementSyntax &) { return count(AnnaNodeKind::ExpressionStatement); }
+    bool visitStatementExpression(AnnaStatementExpressionSyntax &) { return count(AnnaNodeKind::StatementExpression); }
+    bool visitIfStatement(AnnaIfStatementSyntax &) { return count(AnnaNodeKind::IfStatement); }
+    bool visitWhileStatement(AnnaWhileStatementSyntax &) { return count(AnnaNodeKind::WhileStatement); }
+    bool visitAssignment(AnnaAssignmentSyntax &) { return count(AnnaNodeKind::Assignment); }
+    bool visitFormalParameter(AnnaFormalParameterSyntax &) { return count(AnnaNodeKind::FormalParameter); }
+    bool visitReturnStatement(AnnaReturnStatementSyntax &) { return count(AnnaNodeKind::ReturnStatement); }
+    bool visitError(AnnaErrorSyntax &) { return count(AnnaNodeKind::Error); }
+
+    bool visitToken(AnnaToken &) { return count(AnnaNodeKind::Token); }
+    bool visitIdentifierToken(IdentifierToken &) { return count(AnnaNodeKind::IdentifierToken); }
+    bool visitRealToken(RealToken &) { return count(AnnaNodeKind::RealToken); }
+    bool visitIntegerToken(IntegerToken &) { return count(AnnaNodeKind::IntegerToken); }
+    bool visitBooleanToken(BooleanToken &) { return count(AnnaNodeKind::BooleanToken); }
+    bool visitStringToken(StringToken &) { return count(AnnaNodeKind::StringToken); }
+
+private:
+    bool count(AnnaNodeKind kind)
+    {
+        ++_counts[static_cast<size_t>(kind)];
+        return true;
+    }
+
+    KindCounts &_counts;
+};
+
+// Handles one kind and leaves the rest to visitNode()
+class InvocationCounter : public AnnaSwitchVisitor<InvocationCounter>
+{
+public:
+    void visitNode(AnnaNode &) { ++others; }
+    void visitInvocationExpression(AnnaInvocationExpressionSyntax &) { ++invocations; }
+
+    int invocations = 0;
+    int others = 0;
+};
+
+int main()
+{
+    KindCounts total = {};
+
+    int n = 0;
+    for (const char *source : sources) {
+        const std::string name = "source" + std::to_string(n++);
+        const std::string text = source;
+
+        AnnaParser parser(text.data(), text.size(), name, name);
+        gcnCompilationUnit unit = parser.parse();
+        if (!CHECK_MSG(unit != nullptr, name + ": parsed"))
+            continue;
+
+        FlatSyntaxTree tree(unit);
+        KindCounts accepted = {}, switched = {};
+        AcceptCounter acceptCounter(accepted);
+        SwitchCounter switchCounter(switched);
+        InvocationCounter invocationCounter;
+
+        for (FlatSyntaxTree::Index i = 0; i < tree.size(); ++i) {
+            tree.accept(i, acceptCounter);
+            CHECK_MSG(switchCounter.visit(tree.node(i)),
+                      name + ": no visit function for kind " + std::to_string(static_cast<int>(tree.kind(i))));
+            invocationCounter.visit(tree.node(i));
+        }
+
+        for (size_t k = 0; k < KindCount; ++k) {
+            CHECK_MSG(switched[k] == accepted[k], name + ": same count for kind " + std::to_string(k));
+            total[k] += accepted[k];
+        }
+
+        const int invocations = accepted[static_cast<size_t>(AnnaNodeKind::InvocationExpression)];
+        CHECK_MSG(invocationCounter.invocations == invocations, name + ": invocations counted");
+        CHECK_MSG(invocationCounter.invocations + invocationCounter.others == static_cast<int>(tree.size()),
+                  name + ": other nodes fall back to visitNode()");
+    }
+
+    for (size_t k = 0; k < KindCount; ++k)
+        CHECK_MSG(total[k] > 0, "the sources hold a node of kind " + std::to_string(k));
+
+    return test_result();
+}
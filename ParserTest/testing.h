@@ -0,0 +1,96 @@
+/**************************************************************************
+ * Copyright (c) 2015 Afa.L Cheng <afa@afa.moe>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ***************************************************************************/
+
+#ifndef TESTING_H
+#define TESTING_H
+
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "flatsyntaxtree.h"
+#include "parser.h"
+
+// Checks for the test executables. A failed check is reported with its
+// location and counted; main() returns test_result().
+
+inline int &test_failures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+inline bool test_check(bool ok, const std::string &what, const char *file, int line)
+{
+    if (!ok) {
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what.c_str());
+        ++test_failures();
+    }
+    return ok;
+}
+
+inline int test_result()
+{
+    if (test_failures())
+        std::fprintf(stderr, "%d check(s) failed\n", test_failures());
+    return test_failures() ? 1 : 0;
+}
+
+// One line per node in preorder, indented by depth: the kind, and for
+// tokens the token kind, position and text
+inline std::string dump_tree(gcnCompilationUnit unit)
+{
+    if (!unit)
+        return "(null)\n";
+
+    FlatSyntaxTree tree(unit);
+    std::ostringstream out;
+    std::vector<int> depths(tree.size(), 0);
+    for (FlatSyntaxTree::Index i = 0; i < tree.size(); ++i) {
+        if (tree.parent(i) != FlatSyntaxTree::None)
+            depths[i] = depths[tree.parent(i)] + 1;
+        out << std::string(2 * depths[i], ' ') << static_cast<int>(tree.kind(i));
+        if (tree.isToken(i))
+            out << " " << AnnaToken::spelling(tree.token(i)) << " " << tree.row(i) << ":" << tree.col(i)
+                << " `" << tree.text(i) << "'";
+        out << "\n";
+    }
+    return out.str();
+}
+
+// What printErrors() prints
+inline std::string printed_errors(AnnaParser &parser)
+{
+    std::ostringstream out;
+    std::streambuf *old = std::cout.rdbuf(out.rdbuf());
+    parser.printErrors();
+    std::cout.rdbuf(old);
+    return out.str();
+}
+
+#define CHECK(condition) test_check((condition), #condition, __FILE__, __LINE__)
+#define CHECK_MSG(condition, what) test_check((condition), (what), __FILE__, __LINE__)
+
+#endif // TESTING_H
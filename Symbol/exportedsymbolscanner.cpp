@@ -0,0 +1,76 @@
+/**************************************************************************
+ * Copyright (c) 2015 Afa.L Cheng <afa@afa.moe>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ***************************************************************************/
+
+#include "exportedsymbolscanner.h"
+#include "annasyntax.h"
+
+static gcString identifierAt(const FlatSyntaxTree &tree, FlatSyntaxTree::Index i)
+{
+    return static_cast<IdentifierToken &>(tree.node(i)).identifier();
+}
+
+ExportedSymbolScanner::ExportedSymbolScanner(const FlatSyntaxTree &tree)
+{
+    typedef FlatSyntaxTree::Index Index;
+
+    Index root = tree.root();
+    if (root == FlatSyntaxTree::None)
+        return;
+
+    // Declarations come grouped as in AnnaCompilationUnitSyntax, so one
+    // pass gives the same order as the visitor
+    for (const Index *it = tree.childrenBegin(root); it != tree.childrenEnd(root); ++it) {
+        Index decl = *it;
+
+        switch (tree.kind(decl)) {
+            case AnnaNodeKind::VariableDeclarationStatement: {
+                // var VARIABLE_IDENTIFIER ...
+                gcVariableDeclarationSymbol varSymbol = std::make_shared<VariableDeclarationSymbol>();
+                varSymbol->name = identifierAt(tree, tree.child(decl, 1));
+                _symbols.globals.push_back(varSymbol);
+                break;
+            }
+            case AnnaNodeKind::FunctionDefinition: {
+                // def USER_FUNCTION_IDENTIFIER ( formal_parameter_list_opt )
+                gcFunctionDefinitionSymbol funcSymbol = std::make_shared<FunctionDefinitionSymbol>();
+                Index header = tree.child(decl, 0);
+                funcSymbol->name = identifierAt(tree, tree.child(header, 1));
+
+                Index params = tree.child(header, 3);
+                if (tree.kind(params) == AnnaNodeKind::FormalParameterList) {
+                    for (const Index *p = tree.childrenBegin(params); p != tree.childrenEnd(params); ++p)
+                        if (tree.kind(*p) == AnnaNodeKind::FormalParameter)
+                            ++funcSymbol->paramsCount;
+                }
+
+                _symbols.functions.push_back(funcSymbol);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    _symbols.compilationUnitName = tree.unit()->compilationUnitName;
+}
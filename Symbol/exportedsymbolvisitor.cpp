@@ -210,6 +210,12 @@ void ExportedSymbolVisitor::Visit(AnnaReturnStatementSyntax &node)
     assert(false);
 }
 
+void ExportedSymbolVisitor::Visit(AnnaErrorSyntax &node)
+{
+    (void)node;
+    assert(false);
+}
+
 void ExportedSymbolVisitor::Visit(AnnaAssignmentSyntax &node)
 {
     (void)node;
@@ -243,7 +249,7 @@ void ExportedSymbolVisitor::Visit(AnnaSelectionStatementSyntax &node)
 void ExportedSymbolVisitor::Visit(AnnaStatementExpressionSyntax &node)
 {
     (void)node;
-    throw; // Abstract class
+    assert(false);
 }
 
 void ExportedSymbolVisitor::Visit(AnnaFormalParameterSyntax &node)
@@ -69,6 +69,7 @@ public:
     virtual void Visit(AnnaAssignmentSyntax &node);
     virtual void Visit(AnnaFormalParameterSyntax &node);
     virtual void Visit(AnnaReturnStatementSyntax &node);
+    virtual void Visit(AnnaErrorSyntax &node);
 
     // Tokens
     virtual void Visit(AnnaToken &node);
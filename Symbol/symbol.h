@@ -58,7 +58,7 @@ class ParameterDeclarationSymbol : public Symbol
 class FunctionDefinitionSymbol : public Symbol
 {
 public:
-    int paramsCount;
+    int paramsCount = 0;
 };
 
 
@@ -62,6 +62,8 @@ int main(int argc, char **argv)
 
     AnnaParser parser(f, "sample.anna", compilationUnitName);
     gcnCompilationUnit root = parser.parse();
+    // A tree with error nodes is still plotted
+    bool failed = parser.hasErrors();
     parser.printErrors();
 
     if (!root) {
@@ -79,7 +81,7 @@ int main(int argc, char **argv)
     }
     dotfile << dot;
 
-    return 0;
+    return failed ? 1 : 0;
 }
 
 void printVersion()
@@ -99,6 +99,9 @@ void SyntaxPlotterSyntaxVisitor::Visit(AnnaCompilationUnitSyntax &node)
     for (auto funcDefs : node.functionDefinitions)
         funcDefs->Accept(*this);
 
+    for (auto error : node.errors)
+        error->Accept(*this);
+
     exitNode();
 }
 
@@ -287,7 +290,7 @@ void SyntaxPlotterSyntaxVisitor::Visit(IdentifierToken &node)
 
 void SyntaxPlotterSyntaxVisitor::Visit(AnnaToken &node)
 {
-    createTokenNode("Token", node.row(), node.col(), *node.text(), node.trailingComments());
+    createTokenNode("Token", node.row(), node.col(), node.text(), node.trailingComments());
 }
 
 void SyntaxPlotterSyntaxVisitor::Visit(AnnaEOSSyntax &node)
@@ -312,6 +315,16 @@ void SyntaxPlotterSyntaxVisitor::Visit(AnnaReturnStatementSyntax &node)
     exitNode();
 }
 
+void SyntaxPlotterSyntaxVisitor::Visit(AnnaErrorSyntax &node)
+{
+    enterSyntaxNode("error");
+
+    for (auto t : node.tokens)
+        t->Accept(*this);
+
+    exitNode();
+}
+
 void SyntaxPlotterSyntaxVisitor::Visit(AnnaAssignmentSyntax &node)
 {
     enterSyntaxNode("assignment");
@@ -368,8 +381,11 @@ void SyntaxPlotterSyntaxVisitor::Visit(AnnaSelectionStatementSyntax &node)
 
 void SyntaxPlotterSyntaxVisitor::Visit(AnnaStatementExpressionSyntax &node)
 {
-    (void)node;
-    throw; // Abstract class
+    // Plotted as the invocation or assignment it wraps
+    if (node.isAssignment)
+        node.assignment_opt->Accept(*this);
+    else
+        node.invocationExpression_opt->Accept(*this);
 }
 
 void SyntaxPlotterSyntaxVisitor::Visit(AnnaFormalParameterSyntax &node)
@@ -92,6 +92,7 @@ public:
     virtual void Visit(AnnaWhileStatementSyntax &node);
     virtual void Visit(AnnaAssignmentSyntax &node);
     virtual void Visit(AnnaReturnStatementSyntax &node);
+    virtual void Visit(AnnaErrorSyntax &node);
     virtual void Visit(AnnaEOSSyntax &node);
 
     // Tokens
@@ -116,7 +117,7 @@ protected:
     }
 
     SyntaxGraphDescriptor createTokenNode(const std::string &name, int row, int col,
-                                       const std::string &text, std::vector<std::string> comments)
+                                       const std::string &text, const std::vector<std::string> &comments)
     {
         SyntaxGraphDescriptor g = graph.add_vertex();
         graph[g].type = NodeProperty::Token;